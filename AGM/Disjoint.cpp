@@ -1,7 +1,14 @@
 #include "Disjoint.h"
+#include "Instrumentation.h"
 
 // Constructor: Initializes 'element_count' elements
 Disjoint::Disjoint(int element_count) {
+    reset(element_count);
+}
+
+// Reinitializes 'element_count' singleton sets. Does not allocate when the
+// vectors already have the capacity (e.g. when reused for a same-size image).
+void Disjoint::reset(int element_count) {
     parent.resize(element_count);
     component_size.resize(element_count);
     max_internal_edge.resize(element_count);
@@ -29,10 +36,20 @@ bool Disjoint::unite_sets(int root1, int root2, double edge_weight) {
 }
 
 // Finds the root of the set containing 'idx' with path compression.
+// Iterative, so deep trees cannot overflow the stack on very large images.
 int Disjoint::find_set_root(int idx) {
-    if (parent[idx] == idx) { // If 'idx' is its own parent
-        return idx;
+    AGM_STATS_ADD(find_calls, 1);
+
+    int root = idx;
+    while (parent[root] != root) { // Walk up to the root
+        root = parent[root];
+        AGM_STATS_ADD(find_path_steps, 1);
     }
 
-    return parent[idx] = find_set_root(parent[idx]);
+    while (parent[idx] != root) { // Point every element on the path directly at the root
+        int next = parent[idx];
+        parent[idx] = root;
+        idx = next;
+    }
+    return root;
 }
\ No newline at end of file
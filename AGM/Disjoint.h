@@ -11,6 +11,8 @@ public:
 
     Disjoint(int element_count);// Disjoint constructor
 
+    void reset(int element_count); // Makes every element its own set again, reusing the existing storage
+
     int find_set_root(int idx); //Finds the root of idx.
 
     bool unite_sets(int idx1, int idx2, double edge_weight); //joins the sets with idx1 and idx2
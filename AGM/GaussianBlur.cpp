@@ -2,6 +2,8 @@
 #include <cmath>
 #include <algorithm>
 #include "GaussianBlur.h"
+#include "Instrumentation.h"
+#include "Parallel.h"
 
 std::vector<float> GaussianBlur::convertPixelArrayToFloatRGB(const std::vector<Pixel>& pixels, int width, int height) {
     std::vector<float> floatData(width * height * 3);
@@ -24,18 +26,145 @@ void GaussianBlur::convertFloatRGBToPixelArray(const std::vector<float>& floatDa
 }
 
 void GaussianBlur::applyGaussianBlurToImage(Image& image, float sigma) {
-    // Convert Pixel array to float RGB
-    std::vector<float> floatData = GaussianBlur::convertPixelArrayToFloatRGB(image.pixel_data, image.width, image.height);
+    BlurWorkspace workspace;
+    applyGaussianBlurToImage(image, sigma, workspace);
+}
+
+// Blurs one channel at a time on flat planes: extract, convolve horizontally
+// into 'temp', vertically back into 'plane', then write back with clamping.
+// Same arithmetic as ApplyToRGB, so the result is identical.
+void GaussianBlur::applyGaussianBlurToImage(Image& image, float sigma, BlurWorkspace& workspace) {
+    AGM_STATS_TIMER(blur_ms);
+
+    int width = image.width;
+    int height = image.height;
+    if (workspace.kernel_sigma != sigma) {
+        workspace.kernel = GenerateKernel(sigma);
+        workspace.kernel_sigma = sigma;
+    }
+    const std::vector<float>& kernel = workspace.kernel;
+    int radius = static_cast<int>(kernel.size()) / 2;
+
+    std::vector<float>& plane = workspace.plane;
+    std::vector<float>& temp = workspace.temp;
+    plane.resize(static_cast<size_t>(width) * height);
+    temp.resize(static_cast<size_t>(width) * height);
+
+    for (int channel = 0; channel < 3; ++channel) {
+        // Extract channel
+        for (int i = 0; i < width * height; ++i) {
+            const Pixel& p = image.pixel_data[i];
+            plane[i] = channel == 0 ? p.r : (channel == 1 ? p.g : p.b);
+        }
+
+        // Horizontal pass, in bands of rows
+        Parallel::forRanges(0, height, [&](int from_row, int to_row, int) {
+            for (int y = from_row; y < to_row; ++y) {
+                const float* row = &plane[static_cast<size_t>(y) * width];
+                float* out = &temp[static_cast<size_t>(y) * width];
+                for (int x = 0; x < width; ++x) {
+                    float sum = 0.0f;
+                    for (int k = -radius; k <= radius; ++k) {
+                        sum += row[std::clamp(x + k, 0, width - 1)] * kernel[k + radius];
+                    }
+                    out[x] = sum;
+                }
+            }
+        });
+
+        // Vertical pass, in bands of rows
+        Parallel::forRanges(0, height, [&](int from_row, int to_row, int) {
+            for (int y = from_row; y < to_row; ++y) {
+                float* out = &plane[static_cast<size_t>(y) * width];
+                for (int x = 0; x < width; ++x) {
+                    float sum = 0.0f;
+                    for (int k = -radius; k <= radius; ++k) {
+                        sum += temp[static_cast<size_t>(std::clamp(y + k, 0, height - 1)) * width + x] * kernel[k + radius];
+                    }
+                    out[x] = sum;
+                }
+            }
+        });
+
+        // Write back
+        for (int i = 0; i < width * height; ++i) {
+            unsigned char value = static_cast<unsigned char>(std::clamp(plane[i], 0.0f, 255.0f));
+            Pixel& p = image.pixel_data[i];
+            (channel == 0 ? p.r : (channel == 1 ? p.g : p.b)) = value;
+        }
+    }
+}
 
-    // Apply Gaussian Blur
-    GaussianBlur::ApplyToRGB(floatData.data(), image.width, image.height, sigma);
+// Same arithmetic as applyGaussianBlurToImage, restricted to a window: the horizontal
+// pass covers the rows the vertical pass reads (region rows +- radius, clamped).
+void GaussianBlur::applyGaussianBlurInStrips(Image& image, float sigma, int strip_rows, BlurWorkspace& workspace) {
+    Image source = image;
+    strip_rows = std::max(1, strip_rows);
+    for (int y = 0; y < image.height; y += strip_rows) {
+        blurRegion(source, image, {0, y, image.width, std::min(strip_rows, image.height - y)}, sigma, workspace);
+    }
+}
+
+void GaussianBlur::blurRegion(const Image& source, Image& blurred, Rect region, float sigma, BlurWorkspace& workspace) {
+    AGM_STATS_TIMER(blur_ms);
+
+    int width = source.width;
+    int height = source.height;
+    region = region.expandedWithin(0, width, height);
+    if (region.empty()) return;
+    if (workspace.kernel_sigma != sigma) {
+        workspace.kernel = GenerateKernel(sigma);
+        workspace.kernel_sigma = sigma;
+    }
+    const std::vector<float>& kernel = workspace.kernel;
+    int radius = static_cast<int>(kernel.size()) / 2;
+
+    int row0 = std::max(0, region.y - radius);
+    int row1 = std::min(height, region.y + region.height + radius);
+    int cols = region.width;
+    std::vector<float>& temp = workspace.temp;
+    temp.resize(static_cast<size_t>(row1 - row0) * cols);
+
+    for (int channel = 0; channel < 3; ++channel) {
+        auto value = [&](int y, int x) {
+            const Pixel& p = source.pixel_data[source.index(y, x)];
+            return static_cast<float>(channel == 0 ? p.r : (channel == 1 ? p.g : p.b));
+        };
+
+        // Horizontal pass over the rows the vertical pass needs
+        for (int y = row0; y < row1; ++y) {
+            float* out = &temp[static_cast<size_t>(y - row0) * cols];
+            for (int x = region.x; x < region.x + cols; ++x) {
+                float sum = 0.0f;
+                for (int k = -radius; k <= radius; ++k) {
+                    sum += value(y, std::clamp(x + k, 0, width - 1)) * kernel[k + radius];
+                }
+                out[x - region.x] = sum;
+            }
+        }
+
+        // Vertical pass, written straight back to 'blurred'
+        for (int y = region.y; y < region.y + region.height; ++y) {
+            for (int x = region.x; x < region.x + cols; ++x) {
+                float sum = 0.0f;
+                for (int k = -radius; k <= radius; ++k) {
+                    int iy = std::clamp(y + k, 0, height - 1);
+                    sum += temp[static_cast<size_t>(iy - row0) * cols + (x - region.x)] * kernel[k + radius];
+                }
+                unsigned char result = static_cast<unsigned char>(std::clamp(sum, 0.0f, 255.0f));
+                Pixel& p = blurred.pixel_data[blurred.index(y, x)];
+                (channel == 0 ? p.r : (channel == 1 ? p.g : p.b)) = result;
+            }
+        }
+    }
+}
 
-    // Convert back to Pixel array
-    GaussianBlur::convertFloatRGBToPixelArray(floatData, image.pixel_data, image.width, image.height);
+int GaussianBlur::KernelRadius(float sigma) {
+    return static_cast<int>(std::ceil(3.0f * sigma));
 }
 
 std::vector<float> GaussianBlur::GenerateKernel(float sigma) {
-    int radius = static_cast<int>(std::ceil(3.0f * sigma));
+    int radius = KernelRadius(sigma);
     int size = 2 * radius + 1;
     std::vector<float> kernel(size);
     float sum = 0.0f;
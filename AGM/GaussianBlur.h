@@ -2,6 +2,16 @@
 #define GAUSSIAN_BLUR_H
 #include <vector>
 #include "Image.h"
+#include "Rect.h"
+
+// Scratch buffers for applyGaussianBlurToImage, reusable across calls so that
+// repeated blurs of same-size (or smaller) images do not allocate.
+struct BlurWorkspace {
+    std::vector<float> plane;  // One channel of the image, row-major
+    std::vector<float> temp;   // Horizontal pass output
+    std::vector<float> kernel; // Kernel for 'kernel_sigma'
+    float kernel_sigma = -1.0f;
+};
 
 class GaussianBlur {
 public:
@@ -18,6 +28,22 @@ public:
 
     static void applyGaussianBlurToImage(Image& image, float sigma);
 
+    // Same as above, using the scratch buffers of 'workspace'.
+    static void applyGaussianBlurToImage(Image& image, float sigma, BlurWorkspace& workspace);
+
+    // Recomputes 'blurred' (the applyGaussianBlurToImage result of 'source') inside 'region' only,
+    // after 'source' changed there. Call it with the changed rectangle grown by the kernel radius
+    // (KernelRadius). Reads 'source' up to one radius outside 'region'; results are identical to
+    // blurring the whole image.
+    static void blurRegion(const Image& source, Image& blurred, Rect region, float sigma, BlurWorkspace& workspace);
+
+    // Same result as applyGaussianBlurToImage, computed 'strip_rows' rows at a time with blurRegion:
+    // needs a copy of the image but only strip-sized float scratch instead of two full float planes.
+    static void applyGaussianBlurInStrips(Image& image, float sigma, int strip_rows, BlurWorkspace& workspace);
+
+    // Radius in pixels of the kernel GenerateKernel(sigma) produces.
+    static int KernelRadius(float sigma);
+
     // Generates a 1D Gaussian kernel for given sigma
     static std::vector<float> GenerateKernel(float sigma);
 
@@ -0,0 +1,28 @@
+#include "Instrumentation.h"
+#include <iomanip>
+
+void Instrumentation::report(std::ostream& out) {
+    if (!enabled()) {
+        out << "Statistics are not available: rebuild with -DAGM_ENABLE_STATS" << std::endl;
+        return;
+    }
+
+    const PipelineStats& s = current;
+    double total_ms = s.load_ms + s.blur_ms + s.graph_ms + s.sort_ms + s.merge_ms + s.label_ms + s.save_ms;
+    out << std::fixed << std::setprecision(2);
+    out << "---- Pipeline statistics ----" << std::endl;
+    out << "load      " << std::setw(10) << s.load_ms << " ms" << std::endl;
+    out << "blur      " << std::setw(10) << s.blur_ms << " ms" << std::endl;
+    out << "graph     " << std::setw(10) << s.graph_ms << " ms" << std::endl;
+    out << "sort      " << std::setw(10) << s.sort_ms << " ms" << std::endl;
+    out << "merge     " << std::setw(10) << s.merge_ms << " ms" << std::endl;
+    out << "label     " << std::setw(10) << s.label_ms << " ms" << std::endl;
+    out << "save      " << std::setw(10) << s.save_ms << " ms" << std::endl;
+    out << "total     " << std::setw(10) << total_ms << " ms" << std::endl;
+    out << "edges             " << s.edges << std::endl;
+    out << "merges            " << s.merges << std::endl;
+    out << "find calls        " << s.find_calls << std::endl;
+    out << "avg path length   " << s.averagePathLength() << std::endl;
+    out << "segments          " << s.segments << std::endl;
+    out << std::defaultfloat;
+}
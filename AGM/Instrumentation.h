@@ -0,0 +1,69 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <chrono>
+#include <ostream>
+
+// Stage timers and algorithm counters for the Felzenszwalb pipeline.
+// Only compiled in with -DAGM_ENABLE_STATS; otherwise the AGM_STATS_* macros expand to nothing.
+// Counters are plain (non-atomic) and must only be updated from serial code.
+struct PipelineStats {
+    // Wall time per stage, in milliseconds (accumulated over all images of a run)
+    double load_ms = 0, blur_ms = 0, graph_ms = 0, sort_ms = 0, merge_ms = 0, label_ms = 0, save_ms = 0;
+
+    long long edges = 0;           // Edges created by createGraph
+    long long merges = 0;          // Successful unions in the merge loop
+    long long find_calls = 0;      // Calls to Disjoint::find_set_root
+    long long find_path_steps = 0; // Parent links followed by find_set_root
+    long long segments = 0;        // Final segment count
+
+    // Average number of parent links followed per find_set_root call
+    double averagePathLength() const { return find_calls ? static_cast<double>(find_path_steps) / find_calls : 0.0; }
+};
+
+class Instrumentation {
+public:
+    // True when built with AGM_ENABLE_STATS.
+    static constexpr bool enabled() {
+#ifdef AGM_ENABLE_STATS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // The statistics of the current run.
+    static PipelineStats& stats() { return current; }
+
+    // Clears all timers and counters.
+    static void reset() { current = PipelineStats(); }
+
+    // Prints the timers and counters in a human readable table.
+    static void report(std::ostream& out);
+
+private:
+    inline static PipelineStats current;
+};
+
+// Adds the lifetime of the object to a stage timer.
+class ScopedStageTimer {
+public:
+    explicit ScopedStageTimer(double& target_ms) : target(target_ms), start(std::chrono::steady_clock::now()) {}
+    ~ScopedStageTimer() {
+        target += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    double& target;
+    std::chrono::steady_clock::time_point start;
+};
+
+#ifdef AGM_ENABLE_STATS
+#define AGM_STATS_TIMER(field) ScopedStageTimer agm_stats_timer_##field(Instrumentation::stats().field)
+#define AGM_STATS_ADD(field, amount) (Instrumentation::stats().field += (amount))
+#else
+#define AGM_STATS_TIMER(field) ((void)0)
+#define AGM_STATS_ADD(field, amount) ((void)0)
+#endif
+
+#endif // INSTRUMENTATION_H
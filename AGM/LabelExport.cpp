@@ -0,0 +1,123 @@
+#include "LabelExport.h"
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+
+// Appends 'value' to 'out' as 'bytes' little-endian bytes, independent of host byte order.
+static void putLittleEndian(std::vector<char>& out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+int LabelExport::compactLabels(const std::vector<int>& labels, std::vector<int>& compact) {
+    std::unordered_map<int, int> remap;
+    compact.resize(labels.size());
+    for (size_t i = 0; i < labels.size(); ++i) {
+        auto it = remap.find(labels[i]);
+        if (it == remap.end()) {
+            it = remap.emplace(labels[i], static_cast<int>(remap.size())).first;
+        }
+        compact[i] = it->second;
+    }
+    return static_cast<int>(remap.size());
+}
+
+bool LabelExport::writeNpy(const std::vector<int>& labels, int width, int height, const std::string& filename, DType dtype) {
+    size_t total_pixels = static_cast<size_t>(width) * height;
+    if (labels.size() != total_pixels) {
+        std::cerr << "Error: label map size does not match " << width << "x" << height << std::endl;
+        return false;
+    }
+
+    const std::vector<int>* values = &labels;
+    std::vector<int> compact;
+    if (dtype == DType::UInt16) {
+        bool fits = true;
+        for (int label : labels) {
+            if (label < 0 || label > 0xFFFF) { fits = false; break; }
+        }
+        if (!fits) {
+            if (compactLabels(labels, compact) > 0x10000) {
+                std::cerr << "Error: too many segments for a uint16 label map" << std::endl;
+                return false;
+            }
+            values = &compact;
+        }
+    }
+
+    // Header dictionary, padded with spaces so the data starts on a 64-byte boundary
+    std::string header = "{'descr': '" + std::string(dtype == DType::Int32 ? "<i4" : "<u2") +
+                         "', 'fortran_order': False, 'shape': (" + std::to_string(height) + ", " +
+                         std::to_string(width) + "), }";
+    size_t preamble = 10; // magic (6) + version (2) + header length (2)
+    size_t padded = ((preamble + header.size() + 1 + 63) / 64) * 64;
+    header.append(padded - preamble - header.size() - 1, ' ');
+    header.push_back('\n');
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file) {
+        std::cerr << "Error: Could not open " << filename << " for writing" << std::endl;
+        return false;
+    }
+
+    std::vector<char> buffer;
+    buffer.insert(buffer.end(), {'\x93', 'N', 'U', 'M', 'P', 'Y', 1, 0});
+    putLittleEndian(buffer, header.size(), 2);
+    buffer.insert(buffer.end(), header.begin(), header.end());
+    file.write(buffer.data(), buffer.size());
+
+    // Data, written one row at a time
+    int bytes = dtype == DType::Int32 ? 4 : 2;
+    for (int r = 0; r < height; ++r) {
+        buffer.clear();
+        for (int c = 0; c < width; ++c) {
+            putLittleEndian(buffer, static_cast<uint32_t>((*values)[static_cast<size_t>(r) * width + c]), bytes);
+        }
+        file.write(buffer.data(), buffer.size());
+    }
+
+    if (!file) {
+        std::cerr << "Error: Could not write label map to " << filename << std::endl;
+        return false;
+    }
+    std::cout << "Label map saved to " << filename << std::endl;
+    return true;
+}
+
+bool LabelExport::writeRLE(const std::vector<int>& labels, int width, int height, const std::string& filename) {
+    size_t total_pixels = static_cast<size_t>(width) * height;
+    if (labels.size() != total_pixels) {
+        std::cerr << "Error: label map size does not match " << width << "x" << height << std::endl;
+        return false;
+    }
+
+    std::vector<char> runs;
+    uint64_t run_count = 0;
+    size_t i = 0;
+    while (i < total_pixels) {
+        size_t start = i;
+        while (i < total_pixels && labels[i] == labels[start] && i - start < 0xFFFFFFFFu) {
+            ++i;
+        }
+        putLittleEndian(runs, static_cast<uint32_t>(labels[start]), 4);
+        putLittleEndian(runs, i - start, 4);
+        ++run_count;
+    }
+
+    std::vector<char> header = {'L', 'R', 'L', 'E'};
+    putLittleEndian(header, 1, 4);
+    putLittleEndian(header, width, 4);
+    putLittleEndian(header, height, 4);
+    putLittleEndian(header, run_count, 8);
+
+    std::ofstream file(filename, std::ios::binary);
+    file.write(header.data(), header.size());
+    file.write(runs.data(), runs.size());
+    if (!file) {
+        std::cerr << "Error: Could not write label map to " << filename << std::endl;
+        return false;
+    }
+    std::cout << "Label map saved to " << filename << " (" << run_count << " runs)" << std::endl;
+    return true;
+}
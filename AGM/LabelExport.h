@@ -0,0 +1,27 @@
+#ifndef LABEL_EXPORT_H
+#define LABEL_EXPORT_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+// Writes segmentation label maps directly, without the colour visualization step.
+class LabelExport {
+public:
+    enum class DType { Int32, UInt16 }; // Element type of the .npy array
+
+    // Writes the labels as a NumPy .npy array (version 1.0) of shape (height, width), little-endian.
+    // Int32 writes the labels unchanged. UInt16 writes them unchanged when they all fit in [0, 65535],
+    // otherwise they are renumbered 0..n-1 in order of first appearance (fails if n > 65536).
+    static bool writeNpy(const std::vector<int>& labels, int width, int height, const std::string& filename, DType dtype = DType::Int32);
+
+    // Writes the labels run-length encoded in row-major order (runs may cross rows).
+    // Layout, all little-endian: "LRLE" | uint32 version (1) | uint32 width | uint32 height |
+    // uint64 run_count | run_count x (int32 label, uint32 length)
+    static bool writeRLE(const std::vector<int>& labels, int width, int height, const std::string& filename);
+
+    // Renumbers labels to 0..n-1 in order of first appearance. Returns n.
+    static int compactLabels(const std::vector<int>& labels, std::vector<int>& compact);
+};
+
+#endif // LABEL_EXPORT_H
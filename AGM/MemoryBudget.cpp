@@ -0,0 +1,103 @@
+#include "MemoryBudget.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <sys/resource.h>
+
+// Bytes per pixel of each buffer (Pixel is 3 bytes, Edge 16, Disjoint 4 + 8 + 4).
+static const size_t IMAGE_BYTES = 3;
+static const size_t FLOAT_PLANES_BYTES = 2 * sizeof(float); // BlurWorkspace plane + temp
+static const size_t EDGE_BYTES = 2 * 16;                    // About two 4-connectivity edges per pixel
+static const size_t COMPACT_EDGE_BYTES = 2 * 8;
+static const size_t DISJOINT_BYTES = 16;
+static const size_t LABEL_BYTES = 4;
+static const size_t FIXED_OVERHEAD = 8u << 20; // Code, stdio buffers, allocator slack
+// The per-segment sizes of resegmentRect (another 12 bytes per pixel) are left out: the budgeted
+// paths never set SegmentationWorkspace::keep_segment_sizes, so segment() does not allocate them.
+
+size_t MemoryBudget::estimate(MemoryStrategy strategy, int width, int height, int tile_size) {
+    size_t n = static_cast<size_t>(width) * height;
+
+    // Phases that never overlap; the peak is the largest one
+    size_t load = 2 * IMAGE_BYTES * n;                  // stb buffer + Image
+    size_t save = (LABEL_BYTES + 2 * IMAGE_BYTES) * n   // Labels + visualization + PNG buffer,
+                  + IMAGE_BYTES * n                     // next to the blurred image,
+                  + 2 * IMAGE_BYTES * n;                // plus stb's filtered rows and zlib output
+    size_t blur = 0, segment = 0;
+
+    switch (strategy) {
+    case MemoryStrategy::Full:
+        blur = (IMAGE_BYTES + FLOAT_PLANES_BYTES) * n;
+        segment = (IMAGE_BYTES + EDGE_BYTES + DISJOINT_BYTES + LABEL_BYTES) * n;
+        break;
+    case MemoryStrategy::CompactEdges:
+        blur = 2 * IMAGE_BYTES * n; // Source copy + output; the strip scratch is negligible
+        segment = (IMAGE_BYTES + COMPACT_EDGE_BYTES + DISJOINT_BYTES + LABEL_BYTES) * n;
+        break;
+    case MemoryStrategy::Strips: {
+        size_t tile = static_cast<size_t>(tile_size) * tile_size;
+        blur = 2 * IMAGE_BYTES * n;
+        // Tile results and stitched labels for the whole image, plus one tile's full pipeline
+        segment = (IMAGE_BYTES + 2 * LABEL_BYTES) * n +
+                  (IMAGE_BYTES + EDGE_BYTES + DISJOINT_BYTES + 3 * LABEL_BYTES) * tile;
+        break;
+    }
+    case MemoryStrategy::Refuse:
+        return 0;
+    }
+    return std::max({load, blur, segment, save}) + FIXED_OVERHEAD;
+}
+
+MemoryPlan MemoryBudget::plan(int width, int height, size_t limit_bytes) {
+    MemoryPlan plan;
+    plan.full_bytes = estimate(MemoryStrategy::Full, width, height);
+    plan.estimated_bytes = plan.full_bytes;
+    if (limit_bytes == 0 || plan.full_bytes <= limit_bytes) return plan;
+
+    plan.strategy = MemoryStrategy::CompactEdges;
+    plan.estimated_bytes = estimate(plan.strategy, width, height);
+    if (plan.estimated_bytes <= limit_bytes) return plan;
+
+    plan.strategy = MemoryStrategy::Strips;
+    for (int tile = 4096; tile >= 64; tile /= 2) {
+        plan.tile_size = tile;
+        plan.estimated_bytes = estimate(plan.strategy, width, height, tile);
+        if (plan.estimated_bytes <= limit_bytes) return plan;
+    }
+
+    plan.strategy = MemoryStrategy::Refuse;
+    plan.tile_size = 0;
+    return plan;
+}
+
+size_t MemoryBudget::peakResidentBytes() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    return static_cast<size_t>(usage.ru_maxrss) * 1024; // Kilobytes on Linux
+}
+
+size_t MemoryBudget::parseSize(const std::string& text) {
+    char* end = nullptr;
+    double value = std::strtod(text.c_str(), &end);
+    if (end == text.c_str() || value <= 0) return 0;
+
+    double scale = 1;
+    switch (std::toupper(static_cast<unsigned char>(*end))) {
+    case 'K': scale = 1024.0; ++end; break;
+    case 'M': scale = 1024.0 * 1024; ++end; break;
+    case 'G': scale = 1024.0 * 1024 * 1024; ++end; break;
+    }
+    if (std::toupper(static_cast<unsigned char>(*end)) == 'B') ++end; // "2GB", "512B"
+    if (*end != '\0') return 0; // Anything after the unit is a typo, not a size
+    return static_cast<size_t>(value * scale);
+}
+
+const char* MemoryBudget::name(MemoryStrategy strategy) {
+    switch (strategy) {
+    case MemoryStrategy::Full: return "full";
+    case MemoryStrategy::CompactEdges: return "compact edges";
+    case MemoryStrategy::Strips: return "strips";
+    case MemoryStrategy::Refuse: return "refuse";
+    }
+    return "";
+}
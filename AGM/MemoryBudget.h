@@ -0,0 +1,43 @@
+#ifndef MEMORY_BUDGET_H
+#define MEMORY_BUDGET_H
+
+#include <cstddef>
+#include <string>
+
+// How the blur + Felzenszwalb pipeline is run, from most to least memory.
+enum class MemoryStrategy {
+    Full,         // Whole-image float blur planes, 16-byte edges (Segmenter::segment)
+    CompactEdges, // Blur in row strips, 8-byte packed edges (Segmenter::segmentCompact)
+    Strips,       // Blur in row strips, tiles segmented one at a time and stitched (ShardCoordinator)
+    Refuse        // Does not fit even with the smallest tiles
+};
+
+struct MemoryPlan {
+    MemoryStrategy strategy = MemoryStrategy::Full;
+    size_t estimated_bytes = 0; // Estimated peak of the chosen strategy (Refuse: of the smallest tiles)
+    size_t full_bytes = 0;      // Estimated peak of MemoryStrategy::Full, for reference
+    int tile_size = 0;          // Tile side for MemoryStrategy::Strips
+};
+
+// Up-front peak memory estimates of the image_segmenter pipeline (load, blur, segmentation and
+// saving the labels and visualization of one width x height image), used to pick a strategy
+// that fits a memory limit.
+class MemoryBudget {
+public:
+    static size_t estimate(MemoryStrategy strategy, int width, int height, int tile_size = 0);
+
+    // Cheapest-to-run strategy whose estimate fits 'limit_bytes' (0 = no limit, always Full).
+    // Strips uses the largest power-of-two tile (64 to 4096 pixels) that fits.
+    static MemoryPlan plan(int width, int height, size_t limit_bytes);
+
+    // Peak resident set size of this process so far (getrusage), in bytes.
+    static size_t peakResidentBytes();
+
+    // Parses sizes like "512M", "2G", "2GB", "800k" or a plain byte count. Returns 0 if invalid,
+    // including any text left after the unit.
+    static size_t parseSize(const std::string& text);
+
+    static const char* name(MemoryStrategy strategy);
+};
+
+#endif // MEMORY_BUDGET_H
@@ -0,0 +1,138 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Minimal fork-join helper used by the data-parallel passes. Workers are kept alive
+// between calls (started on first use), so a parallel pass does not create threads.
+class Parallel {
+public:
+    // Number of worker threads used by forRanges (defaults to the hardware concurrency).
+    static int threadCount() {
+        if (requested_threads > 0) return requested_threads;
+        int hw = static_cast<int>(std::thread::hardware_concurrency());
+        return hw > 0 ? hw : 1;
+    }
+
+    static void setThreadCount(int threads) { requested_threads = threads; }
+
+    // Starts the pool threads for threadCount() workers now instead of on the first parallel pass.
+    static void warmUp() { pool().ensureThreads(threadCount() - 1); }
+
+    // Splits [begin, end) into one contiguous range per worker and runs fn(from, to, worker) on each.
+    // Worker w always gets the w-th slice, so results merged by worker index are reproducible.
+    // Calls made from inside a worker run inline as a single range.
+    template <typename Fn>
+    static void forRanges(int begin, int end, Fn fn, int workers = 0) {
+        if (workers <= 0) workers = threadCount();
+        workers = std::max(1, std::min(workers, end - begin));
+
+        if (workers == 1 || in_worker) {
+            fn(begin, end, 0);
+            return;
+        }
+
+        Task task;
+        task.run = [](const void* context, int from, int to, int worker) { (*static_cast<const Fn*>(context))(from, to, worker); };
+        task.context = &fn;
+        task.begin = begin;
+        task.span = end - begin;
+        task.workers = workers;
+        pool().run(task);
+    }
+
+private:
+    // One forRanges call, with the callable type erased (no allocation).
+    struct Task {
+        void (*run)(const void* context, int from, int to, int worker) = nullptr;
+        const void* context = nullptr;
+        int begin = 0;
+        long long span = 0;
+        int workers = 1;
+
+        void runSlice(int worker) const {
+            run(context, begin + static_cast<int>(span * worker / workers),
+                begin + static_cast<int>(span * (worker + 1) / workers), worker);
+        }
+    };
+
+    class Pool {
+    public:
+        ~Pool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (std::thread& thread : threads) thread.join();
+        }
+
+        void ensureThreads(int count) {
+            std::lock_guard<std::mutex> lock(mutex);
+            while (static_cast<int>(threads.size()) < count) {
+                int worker = static_cast<int>(threads.size()) + 1; // The caller is worker 0
+                threads.emplace_back([this, worker] { loop(worker); });
+            }
+        }
+
+        void run(const Task& next) {
+            std::lock_guard<std::mutex> caller(dispatch); // One forRanges at a time
+            ensureThreads(next.workers - 1);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                task = next;
+                pending = next.workers - 1;
+                generation++;
+            }
+            wake.notify_all();
+
+            in_worker = true;
+            next.runSlice(0);
+            in_worker = false;
+
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [this] { return pending == 0; });
+        }
+
+    private:
+        void loop(int worker) {
+            in_worker = true;
+            unsigned long long seen = 0;
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+                if (worker >= task.workers) continue; // Not needed for this call
+                Task current = task;
+                lock.unlock();
+                current.runSlice(worker);
+                lock.lock();
+                if (--pending == 0) done.notify_one();
+            }
+        }
+
+        std::vector<std::thread> threads;
+        std::mutex dispatch;
+        std::mutex mutex;
+        std::condition_variable wake, done;
+        Task task;
+        unsigned long long generation = 0;
+        int pending = 0;
+        bool stopping = false;
+    };
+
+    static Pool& pool() {
+        static Pool instance;
+        return instance;
+    }
+
+    inline static int requested_threads = 0;
+    inline static thread_local bool in_worker = false;
+};
+
+#endif // PARALLEL_H
@@ -0,0 +1,195 @@
+#include "PyramidSegmenter.h"
+#include "Segmenter.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+Image PyramidSegmenter::downsample(const Image& image, int factor) {
+    int width = (image.width + factor - 1) / factor;
+    int height = (image.height + factor - 1) / factor;
+    Image small(width, height);
+
+    for (int r = 0; r < height; ++r) {
+        for (int c = 0; c < width; ++c) {
+            int sum_r = 0, sum_g = 0, sum_b = 0, count = 0;
+            for (int y = r * factor; y < std::min(image.height, (r + 1) * factor); ++y) {
+                for (int x = c * factor; x < std::min(image.width, (c + 1) * factor); ++x) {
+                    const Pixel& p = image.pixel_data[image.index(y, x)];
+                    sum_r += p.r;
+                    sum_g += p.g;
+                    sum_b += p.b;
+                    count++;
+                }
+            }
+            small.pixel_data[small.index(r, c)] = {static_cast<unsigned char>((sum_r + count / 2) / count),
+                                                   static_cast<unsigned char>((sum_g + count / 2) / count),
+                                                   static_cast<unsigned char>((sum_b + count / 2) / count)};
+        }
+    }
+    return small;
+}
+
+// Marks pixels whose 4-neighbourhood contains another label.
+static std::vector<unsigned char> boundaryMask(const std::vector<int>& labels, int width, int height) {
+    std::vector<unsigned char> boundary(static_cast<size_t>(width) * height, 0);
+    for (int r = 0; r < height; ++r) {
+        for (int c = 0; c < width; ++c) {
+            int idx = r * width + c;
+            if (c + 1 < width && labels[idx] != labels[idx + 1]) boundary[idx] = boundary[idx + 1] = 1;
+            if (r + 1 < height && labels[idx] != labels[idx + width]) boundary[idx] = boundary[idx + width] = 1;
+        }
+    }
+    return boundary;
+}
+
+// Dilates a mask with a (2 * radius + 1)^2 square, as a horizontal then a vertical running window.
+static void dilate(std::vector<unsigned char>& mask, int width, int height, int radius) {
+    if (radius <= 0) return;
+    std::vector<unsigned char> temp(mask.size(), 0);
+    for (int r = 0; r < height; ++r) {
+        int last = -radius - 1; // Last marked column seen
+        for (int c = 0; c < std::min(width, radius); ++c) if (mask[r * width + c]) last = c;
+        for (int c = 0; c < width; ++c) {
+            if (c + radius < width && mask[r * width + c + radius]) last = c + radius;
+            temp[r * width + c] = last >= c - radius;
+        }
+    }
+    for (int c = 0; c < width; ++c) {
+        int last = -radius - 1;
+        for (int r = 0; r < std::min(height, radius); ++r) if (temp[r * width + c]) last = r;
+        for (int r = 0; r < height; ++r) {
+            if (r + radius < height && temp[(r + radius) * width + c]) last = r + radius;
+            mask[r * width + c] = last >= r - radius;
+        }
+    }
+}
+
+std::vector<int> PyramidSegmenter::segment(const Image& image, double k, int factor, int band, PyramidReport* report, bool deterministic) {
+    int width = image.width;
+    int height = image.height;
+    int total_pixels = width * height;
+    factor = std::max(1, factor);
+
+    // 1. Coarse segmentation. Components have factor^2 fewer pixels, so k is scaled to keep
+    // the size threshold k / |C| comparable.
+    auto start = std::chrono::steady_clock::now();
+    Image small = downsample(image, factor);
+    Segmenter coarse_segmenter(small, deterministic);
+    SegmentationWorkspace coarse;
+    coarse_segmenter.segment(k / (factor * factor), coarse);
+    double coarse_ms = millisecondsSince(start);
+
+    // 2. Upsample the labels and find the band around coarse boundaries
+    start = std::chrono::steady_clock::now();
+    std::vector<int> upsampled(total_pixels);
+    for (int r = 0; r < height; ++r) {
+        for (int c = 0; c < width; ++c) {
+            upsampled[r * width + c] = coarse.labels[small.index(r / factor, c / factor)];
+        }
+    }
+    std::vector<unsigned char> in_band = boundaryMask(upsampled, width, height);
+    dilate(in_band, width, height, band);
+
+    // 3. Interior pixels start merged into one component per coarse segment (represented by
+    // its first interior pixel), carrying the coarse internal difference; band pixels are singletons.
+    Disjoint disjoint_sets(total_pixels);
+    std::vector<int> representative(small.width * small.height, -1);
+    long long band_pixels = 0;
+    for (int i = 0; i < total_pixels; ++i) {
+        if (in_band[i]) {
+            band_pixels++;
+            continue;
+        }
+        int coarse_root = upsampled[i];
+        int& rep = representative[coarse_root];
+        if (rep == -1) {
+            rep = i;
+            disjoint_sets.max_internal_edge[rep] = coarse.disjoint_sets.max_internal_edge[coarse_root];
+        } else {
+            disjoint_sets.parent[i] = rep;
+            disjoint_sets.component_size[rep]++;
+        }
+    }
+
+    // 4. Full-resolution merging restricted to edges that touch the band
+    Segmenter segmenter(image, deterministic);
+    std::vector<Edge> edges;
+    for (int r = 0; r < height; ++r) {
+        for (int c = 0; c < width; ++c) {
+            int idx = r * width + c;
+            if (c + 1 < width && (in_band[idx] || in_band[idx + 1])) {
+                edges.push_back({idx, idx + 1, segmenter.rgbDistance(image.pixel_data[idx], image.pixel_data[idx + 1])});
+            }
+            if (r + 1 < height && (in_band[idx] || in_band[idx + width])) {
+                edges.push_back({idx, idx + width, segmenter.rgbDistance(image.pixel_data[idx], image.pixel_data[idx + width])});
+            }
+        }
+    }
+    segmenter.sortEdges(edges);
+    Segmenter::mergeComponents(edges, k, disjoint_sets);
+
+    std::vector<int> labels(total_pixels);
+    for (int i = 0; i < total_pixels; ++i) {
+        labels[i] = disjoint_sets.find_set_root(i);
+    }
+
+    if (report) {
+        report->coarse_ms = coarse_ms;
+        report->refine_ms = millisecondsSince(start);
+        report->coarse_segments = 0;
+        for (int i = 0; i < small.width * small.height; ++i) {
+            if (coarse.labels[i] == i) report->coarse_segments++;
+        }
+        report->band_pixels = band_pixels;
+    }
+    return labels;
+}
+
+SegmentationQuality PyramidSegmenter::compare(const std::vector<int>& labels, const std::vector<int>& reference, int width, int height) {
+    SegmentationQuality quality;
+    size_t total_pixels = static_cast<size_t>(width) * height;
+
+    // Achievable segmentation accuracy: count (label, reference) overlaps by sorting pair keys
+    std::vector<uint64_t> pairs(total_pixels);
+    for (size_t i = 0; i < total_pixels; ++i) {
+        pairs[i] = (static_cast<uint64_t>(static_cast<uint32_t>(labels[i])) << 32) | static_cast<uint32_t>(reference[i]);
+    }
+    std::sort(pairs.begin(), pairs.end());
+    long long best_overlap_sum = 0, best = 0, run = 0;
+    for (size_t i = 0; i < total_pixels; ++i) {
+        run = (i > 0 && pairs[i] == pairs[i - 1]) ? run + 1 : 1;
+        bool label_ends = i + 1 == total_pixels || (pairs[i + 1] >> 32) != (pairs[i] >> 32);
+        best = std::max(best, run);
+        if (label_ends) {
+            best_overlap_sum += best;
+            best = 0;
+            quality.segments++;
+        }
+    }
+    quality.achievable_accuracy = static_cast<double>(best_overlap_sum) / total_pixels;
+
+    std::vector<int> sorted_reference(reference);
+    std::sort(sorted_reference.begin(), sorted_reference.end());
+    quality.reference_segments = static_cast<int>(std::unique(sorted_reference.begin(), sorted_reference.end()) - sorted_reference.begin());
+
+    // Boundary agreement with a 1-pixel tolerance
+    std::vector<unsigned char> boundary = boundaryMask(labels, width, height);
+    std::vector<unsigned char> reference_boundary = boundaryMask(reference, width, height);
+    std::vector<unsigned char> boundary_near = boundary, reference_near = reference_boundary;
+    dilate(boundary_near, width, height, 1);
+    dilate(reference_near, width, height, 1);
+    long long boundary_count = 0, reference_count = 0, matched = 0, reference_matched = 0;
+    for (size_t i = 0; i < total_pixels; ++i) {
+        boundary_count += boundary[i];
+        reference_count += reference_boundary[i];
+        matched += boundary[i] && reference_near[i];
+        reference_matched += reference_boundary[i] && boundary_near[i];
+    }
+    quality.boundary_precision = boundary_count ? static_cast<double>(matched) / boundary_count : 1.0;
+    quality.boundary_recall = reference_count ? static_cast<double>(reference_matched) / reference_count : 1.0;
+    return quality;
+}
@@ -0,0 +1,44 @@
+#ifndef PYRAMID_SEGMENTER_H
+#define PYRAMID_SEGMENTER_H
+
+#include <vector>
+#include "Image.h"
+
+// Timings and sizes of one PyramidSegmenter::segment call.
+struct PyramidReport {
+    double coarse_ms = 0;     // Downsampling + segmentation at the coarse scale
+    double refine_ms = 0;     // Upsampling, band extraction and full-resolution merging
+    int coarse_segments = 0;
+    long long band_pixels = 0; // Full-resolution pixels re-merged around coarse boundaries
+};
+
+// Agreement of a segmentation with a reference (e.g. the full-resolution result).
+struct SegmentationQuality {
+    int segments = 0;
+    int reference_segments = 0;
+    double achievable_accuracy = 0; // Fraction of pixels in the best-overlapping reference segment (ASA)
+    double boundary_recall = 0;     // Reference boundary pixels with a boundary pixel within 1 px
+    double boundary_precision = 0;  // Boundary pixels with a reference boundary pixel within 1 px
+};
+
+// Approximate Felzenszwalb segmentation for previews and very large inputs: segments a
+// downsampled copy, upsamples the labels, then re-runs the merge at full resolution only
+// in a band around the coarse boundaries. Interior pixels start out already merged into
+// their coarse segment.
+class PyramidSegmenter {
+public:
+    // 'image' is the (blurred) full-resolution image. 'factor' is the downsampling factor per
+    // side (2 -> 1/4 of the pixels, 4 -> 1/16). 'band' is the refinement band half-width in
+    // full-resolution pixels. Labels are root pixel indices, like Segmenter::segment. 'deterministic'
+    // selects Segmenter's deterministic mode for both scales.
+    static std::vector<int> segment(const Image& image, double k, int factor, int band, PyramidReport* report = nullptr,
+                                    bool deterministic = false);
+
+    // Box-filter downsampling by 'factor' per side (partial blocks at the edges are averaged too).
+    static Image downsample(const Image& image, int factor);
+
+    // Compares 'labels' with 'reference', both width x height label maps.
+    static SegmentationQuality compare(const std::vector<int>& labels, const std::vector<int>& reference, int width, int height);
+};
+
+#endif // PYRAMID_SEGMENTER_H
@@ -0,0 +1,22 @@
+#ifndef RECT_H
+#define RECT_H
+
+#include <algorithm>
+
+struct Rect {
+    int x, y;          // Top-left corner (column, row)
+    int width, height; // Size in pixels
+
+    // Rectangle grown by 'margin' on every side and clipped to a w x h image.
+    Rect expandedWithin(int margin, int w, int h) const {
+        int x0 = std::max(0, x - margin);
+        int y0 = std::max(0, y - margin);
+        int x1 = std::min(w, x + width + margin);
+        int y1 = std::min(h, y + height + margin);
+        return {x0, y0, std::max(0, x1 - x0), std::max(0, y1 - y0)};
+    }
+
+    bool empty() const { return width <= 0 || height <= 0; }
+};
+
+#endif // RECT_H
@@ -0,0 +1,135 @@
+#include "RegionAdjacency.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+// RGB distance between two pixels; same measure Segmenter uses for edge weights.
+static double pixelDistance(const Pixel& a, const Pixel& b) {
+    double dr = a.r - b.r, dg = a.g - b.g, db = a.b - b.b;
+    return std::sqrt(dr * dr + dg * dg + db * db);
+}
+
+void RegionAdjacency::reduce(std::vector<PairEntry>& entries) {
+    std::sort(entries.begin(), entries.end(), [](const PairEntry& a, const PairEntry& b) { return a.key < b.key; });
+
+    size_t out = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (out > 0 && entries[out - 1].key == entries[i].key) {
+            entries[out - 1].count += entries[i].count;
+            entries[out - 1].weight_sum += entries[i].weight_sum;
+        } else {
+            entries[out++] = entries[i];
+        }
+    }
+    entries.resize(out);
+}
+
+RegionAdjacencyGraph RegionAdjacency::build(const std::vector<int>& labels, const Image& image) {
+    int width = image.width;
+    int height = image.height;
+    RegionAdjacencyGraph graph;
+
+    // 1. Map label values to dense region ids, in order of first appearance
+    int label_range = 0;
+    for (int label : labels) label_range = std::max(label_range, label + 1);
+    std::vector<int> region_of_label(label_range, -1);
+    for (int label : labels) {
+        if (region_of_label[label] == -1) {
+            region_of_label[label] = graph.regionCount();
+            graph.region_label.push_back(label);
+        }
+    }
+
+    // 2. Right and down neighbours of every pixel, one band of rows per worker. Distances are summed in
+    // WEIGHT_SCALE fixed point, so merging the bands in any order gives the same graph.
+    std::vector<std::vector<PairEntry>> partials(Parallel::threadCount());
+    Parallel::forRanges(0, height, [&](int from_row, int to_row, int worker) {
+        std::vector<PairEntry>& local = partials[worker];
+        auto addPair = [&](int idx1, int idx2) {
+            int region1 = region_of_label[labels[idx1]];
+            int region2 = region_of_label[labels[idx2]];
+            if (region1 == region2) return;
+            if (region1 > region2) std::swap(region1, region2);
+            uint64_t key = (static_cast<uint64_t>(region1) << 32) | static_cast<uint32_t>(region2);
+            local.push_back({key, 1, std::llround(pixelDistance(image.pixel_data[idx1], image.pixel_data[idx2]) * WEIGHT_SCALE)});
+        };
+
+        for (int r = from_row; r < to_row; ++r) {
+            for (int c = 0; c < width; ++c) {
+                int idx = image.index(r, c);
+                if (c + 1 < width) addPair(idx, idx + 1);
+                if (r + 1 < height) addPair(idx, idx + width);
+            }
+        }
+        reduce(local);
+    }, static_cast<int>(partials.size()));
+
+    // 3. Merge the per-worker lists into one list of undirected region pairs
+    std::vector<PairEntry> pairs;
+    for (std::vector<PairEntry>& partial : partials) {
+        pairs.insert(pairs.end(), partial.begin(), partial.end());
+        std::vector<PairEntry>().swap(partial);
+    }
+    reduce(pairs);
+
+    // 4. Build the symmetric CSR structure. Pairs are sorted by (smaller, larger) id, so filling
+    // rows in pair order leaves every row sorted by neighbour id.
+    int regions = graph.regionCount();
+    graph.offsets.assign(regions + 1, 0);
+    for (const PairEntry& pair : pairs) {
+        graph.offsets[(pair.key >> 32) + 1]++;
+        graph.offsets[(pair.key & 0xFFFFFFFFu) + 1]++;
+    }
+    for (int r = 0; r < regions; ++r) graph.offsets[r + 1] += graph.offsets[r];
+
+    size_t entries = graph.offsets[regions];
+    graph.neighbors.resize(entries);
+    graph.boundary_length.resize(entries);
+    graph.mean_weight.resize(entries);
+    std::vector<int> fill(graph.offsets.begin(), graph.offsets.end() - 1);
+    for (const PairEntry& pair : pairs) {
+        int region1 = static_cast<int>(pair.key >> 32);
+        int region2 = static_cast<int>(pair.key & 0xFFFFFFFFu);
+        float mean = static_cast<float>(pair.weight_sum / WEIGHT_SCALE / pair.count);
+
+        int slot1 = fill[region1]++;
+        graph.neighbors[slot1] = region2;
+        graph.boundary_length[slot1] = pair.count;
+        graph.mean_weight[slot1] = mean;
+
+        int slot2 = fill[region2]++;
+        graph.neighbors[slot2] = region1;
+        graph.boundary_length[slot2] = pair.count;
+        graph.mean_weight[slot2] = mean;
+    }
+
+    return graph;
+}
+
+bool RegionAdjacency::writeCSV(const RegionAdjacencyGraph& graph, const std::string& filename) {
+    std::ofstream file(filename);
+    if (!file) {
+        std::cerr << "Error: Could not open " << filename << " for writing" << std::endl;
+        return false;
+    }
+
+    file << "label_a,label_b,boundary_length,mean_weight\n";
+    for (int r = 0; r < graph.regionCount(); ++r) {
+        for (int e = graph.offsets[r]; e < graph.offsets[r + 1]; ++e) {
+            if (graph.neighbors[e] > r) {
+                file << graph.region_label[r] << ',' << graph.region_label[graph.neighbors[e]] << ','
+                     << graph.boundary_length[e] << ',' << graph.mean_weight[e] << '\n';
+            }
+        }
+    }
+
+    if (!file) {
+        std::cerr << "Error: Could not write adjacency graph to " << filename << std::endl;
+        return false;
+    }
+    std::cout << "Region adjacency graph saved to " << filename << " (" << graph.regionCount() << " regions, "
+              << graph.neighbors.size() / 2 << " edges)" << std::endl;
+    return true;
+}
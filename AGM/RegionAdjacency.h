@@ -0,0 +1,45 @@
+#ifndef REGION_ADJACENCY_H
+#define REGION_ADJACENCY_H
+
+#include <vector>
+#include <cstdint>
+#include <string>
+#include "Image.h"
+
+// Region adjacency graph of a label map, in compressed sparse row (CSR) form.
+// Region ids are 0..regionCount()-1; the neighbours of region r are
+// neighbors[offsets[r] .. offsets[r + 1]), sorted by id, with one entry per direction.
+struct RegionAdjacencyGraph {
+    std::vector<int> region_label;    // Label value of each region id
+    std::vector<int> offsets;         // Row offsets, size regionCount() + 1
+    std::vector<int> neighbors;       // Neighbouring region id of each entry
+    std::vector<int> boundary_length; // Number of 4-adjacent pixel pairs shared with that neighbour
+    std::vector<float> mean_weight;   // Mean RGB distance across those pixel pairs
+
+    int regionCount() const { return static_cast<int>(region_label.size()); }
+};
+
+class RegionAdjacency {
+public:
+    // Builds the graph of 'labels' (e.g. Segmenter::segment output, labels in [0, width * height))
+    // with one parallel scan over horizontal and vertical pixel pairs. Edge weights are the
+    // RGB distances between the pixels of 'image' on either side of the boundary.
+    static RegionAdjacencyGraph build(const std::vector<int>& labels, const Image& image);
+
+    // Writes each undirected edge once as CSV: label_a,label_b,boundary_length,mean_weight.
+    static bool writeCSV(const RegionAdjacencyGraph& graph, const std::string& filename);
+
+private:
+    struct PairEntry {
+        uint64_t key;     // (smaller region id << 32) | larger region id
+        int count;
+        int64_t weight_sum; // Fixed point (WEIGHT_SCALE units): integer sums do not depend on the reduction order
+    };
+
+    static constexpr double WEIGHT_SCALE = 1 << 20;
+
+    // Sorts entries by key and merges equal keys in place.
+    static void reduce(std::vector<PairEntry>& entries);
+};
+
+#endif // REGION_ADJACENCY_H
@@ -0,0 +1,110 @@
+#include "SegmentStats.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+SegmentStatistics::SegmentStatistics(int label_range) : slot_of_label(label_range, -1) {}
+
+void SegmentStatistics::add(int label, int x, int y, const Pixel& p) {
+    int& slot = slot_of_label[label];
+    if (slot == -1) {
+        slot = static_cast<int>(accumulators.size());
+        accumulators.push_back({label, 0, x, y, x, y, 0, 0, 0, 0, 0});
+    }
+
+    Accumulator& acc = accumulators[slot];
+    acc.area++;
+    acc.min_x = std::min(acc.min_x, x);
+    acc.min_y = std::min(acc.min_y, y);
+    acc.max_x = std::max(acc.max_x, x);
+    acc.max_y = std::max(acc.max_y, y);
+    acc.sum_x += x;
+    acc.sum_y += y;
+    acc.sum_r += p.r;
+    acc.sum_g += p.g;
+    acc.sum_b += p.b;
+}
+
+std::vector<SegmentStats> SegmentStatistics::table() const {
+    std::vector<SegmentStats> stats;
+    stats.reserve(accumulators.size());
+    for (const Accumulator& acc : accumulators) {
+        double area = static_cast<double>(acc.area);
+        stats.push_back({acc.label, static_cast<int>(acc.area), acc.min_x, acc.min_y, acc.max_x, acc.max_y,
+                         acc.sum_x / area, acc.sum_y / area,
+                         acc.sum_r / area, acc.sum_g / area, acc.sum_b / area});
+    }
+    return stats;
+}
+
+std::vector<SegmentStats> SegmentStatistics::compute(const std::vector<int>& labels, const Image& image) {
+    int label_range = 0;
+    for (int label : labels) label_range = std::max(label_range, label + 1);
+
+    SegmentStatistics statistics(label_range);
+    for (int r = 0; r < image.height; ++r) {
+        for (int c = 0; c < image.width; ++c) {
+            int idx = image.index(r, c);
+            statistics.add(labels[idx], c, r, image.pixel_data[idx]);
+        }
+    }
+    return statistics.table();
+}
+
+bool SegmentStatistics::writeCSV(const std::vector<SegmentStats>& stats, const std::string& filename) {
+    std::ofstream file(filename);
+    if (!file) {
+        std::cerr << "Error: Could not open " << filename << " for writing" << std::endl;
+        return false;
+    }
+
+    file << "label,area,min_x,min_y,max_x,max_y,centroid_x,centroid_y,mean_r,mean_g,mean_b\n";
+    for (const SegmentStats& s : stats) {
+        file << s.label << ',' << s.area << ',' << s.min_x << ',' << s.min_y << ',' << s.max_x << ',' << s.max_y << ','
+             << s.centroid_x << ',' << s.centroid_y << ',' << s.mean_r << ',' << s.mean_g << ',' << s.mean_b << '\n';
+    }
+
+    if (!file) {
+        std::cerr << "Error: Could not write statistics to " << filename << std::endl;
+        return false;
+    }
+    std::cout << "Segment statistics saved to " << filename << " (" << stats.size() << " segments)" << std::endl;
+    return true;
+}
+
+// Appends 'value' to 'out' as 'bytes' little-endian bytes, independent of host byte order.
+static void putLittleEndian(std::vector<char>& out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+static void putDouble(std::vector<char>& out, double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    putLittleEndian(out, bits, 8);
+}
+
+bool SegmentStatistics::writeBinary(const std::vector<SegmentStats>& stats, const std::string& filename) {
+    std::vector<char> buffer = {'S', 'S', 'T', 'A'};
+    putLittleEndian(buffer, 1, 4);
+    putLittleEndian(buffer, stats.size(), 4);
+    for (const SegmentStats& s : stats) {
+        for (int value : {s.label, s.area, s.min_x, s.min_y, s.max_x, s.max_y}) {
+            putLittleEndian(buffer, static_cast<uint32_t>(value), 4);
+        }
+        for (double value : {s.centroid_x, s.centroid_y, s.mean_r, s.mean_g, s.mean_b}) {
+            putDouble(buffer, value);
+        }
+    }
+
+    std::ofstream file(filename, std::ios::binary);
+    file.write(buffer.data(), buffer.size());
+    if (!file) {
+        std::cerr << "Error: Could not write statistics to " << filename << std::endl;
+        return false;
+    }
+    std::cout << "Segment statistics saved to " << filename << " (" << stats.size() << " segments)" << std::endl;
+    return true;
+}
@@ -0,0 +1,56 @@
+#ifndef SEGMENT_STATS_H
+#define SEGMENT_STATS_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "Image.h"
+#include "Pixel.h"
+
+// Summary of one segment of a label map.
+struct SegmentStats {
+    int label;                      // Label value as stored in the label map
+    int area;                       // Number of pixels in the segment
+    int min_x, min_y, max_x, max_y; // Bounding box (inclusive)
+    double centroid_x, centroid_y;  // Mean pixel position
+    double mean_r, mean_g, mean_b;  // Mean colour
+};
+
+// Accumulates per-segment statistics pixel by pixel, so they can be filled in
+// while a label map is being produced instead of rescanning it afterwards.
+class SegmentStatistics {
+public:
+    // 'label_range' bounds the label values that will be added (labels must be in [0, label_range)).
+    SegmentStatistics(int label_range);
+
+    // Adds pixel (x, y) with colour 'p' to segment 'label'.
+    void add(int label, int x, int y, const Pixel& p);
+
+    // Returns the statistics table, one row per segment in order of first appearance.
+    std::vector<SegmentStats> table() const;
+
+    // Computes the table in one pass over an existing label map.
+    static std::vector<SegmentStats> compute(const std::vector<int>& labels, const Image& image);
+
+    // Writes the table as CSV with a header row.
+    static bool writeCSV(const std::vector<SegmentStats>& stats, const std::string& filename);
+
+    // Writes the table as little-endian binary records:
+    // "SSTA" | uint32 version (1) | uint32 count | count x (int32 label, area, min_x, min_y, max_x, max_y,
+    // float64 centroid_x, centroid_y, mean_r, mean_g, mean_b)
+    static bool writeBinary(const std::vector<SegmentStats>& stats, const std::string& filename);
+
+private:
+    struct Accumulator {
+        int label;
+        int64_t area;
+        int min_x, min_y, max_x, max_y;
+        int64_t sum_x, sum_y;
+        int64_t sum_r, sum_g, sum_b;
+    };
+
+    std::vector<int> slot_of_label;   // Index into 'accumulators' for each label, -1 if unseen
+    std::vector<Accumulator> accumulators;
+};
+
+#endif // SEGMENT_STATS_H
@@ -0,0 +1,45 @@
+#ifndef SEGMENTATION_WORKSPACE_H
+#define SEGMENTATION_WORKSPACE_H
+
+#include <vector>
+#include "Edge.h"
+#include "Disjoint.h"
+#include "GaussianBlur.h"
+
+// Owns every scratch buffer of the blur + Felzenszwalb pipeline. Reusing one
+// workspace across calls on images of the same (or smaller) size means that,
+// after the first call, blurring and segmenting do not allocate.
+class SegmentationWorkspace {
+public:
+    BlurWorkspace blur;         // GaussianBlur planes and kernel
+    std::vector<Edge> edges;    // Graph edges, sorted in place
+    std::vector<Edge> edges_dropped; // Out-of-order edges pulled out by Segmenter::updateSortedEdges
+    std::vector<Edge> edges_merged;  // Merge target of Segmenter::updateSortedEdges (swapped with 'edges')
+    Disjoint disjoint_sets{0};  // Union-find state
+    std::vector<int> labels;    // Output label map of the last Segmenter::segment call
+    bool keep_segment_sizes = false;      // Fill segment_size / segment_internal in segment(), as resegmentRect needs
+    std::vector<int> segment_size;        // Pixels per label after segmentSorted, kept up to date by resegmentRect (0: unused)
+    std::vector<double> segment_internal; // Int(C) per label, same indexing
+    int free_label = 0;                   // Where resegmentRect resumes its search for an unused label
+    std::vector<Edge> region_edges;  // Local graph of Segmenter::resegmentRect
+    Disjoint region_sets{0};         // Its union-find state
+    std::vector<int> region_pixels;  // Label of each local root
+    std::vector<int> region_labels;  // Labels found in the region, one entry per pixel
+    std::vector<int> ring_labels;    // Labels on the ring around the region
+    std::vector<int> ring_sizes;     // Pixels of each ring segment outside the region
+    std::vector<int> region_queue;   // Flood fill of remnants relabelled after a merge
+
+    // Pre-sizes the buffers of blur + segment() for a width x height image, so the first such call only
+    // allocates the blur kernel (built once per sigma). The buffers of updateSortedEdges (edges_dropped,
+    // edges_merged) and resegmentRect are left to grow on first use.
+    void reserve(int width, int height) {
+        size_t pixels = static_cast<size_t>(width) * height;
+        blur.plane.reserve(pixels);
+        blur.temp.reserve(pixels);
+        edges.reserve(2 * pixels);
+        disjoint_sets.reset(static_cast<int>(pixels));
+        labels.reserve(pixels);
+    }
+};
+
+#endif // SEGMENTATION_WORKSPACE_H
@@ -1,6 +1,8 @@
 #include "Segmenter.h"
 #include "Disjoint.h"
+#include "Instrumentation.h"
 #include <cmath>
+#include <cstdint>
 #include <algorithm>
 #include <unordered_map>
 #include <iostream>
@@ -9,7 +11,8 @@
 #include <limits>
 
 // Constructor for the Segmenter class. Initializes with the provided image.
-Segmenter::Segmenter(const Image& img) : image(img), width(img.width), height(img.height) {}
+Segmenter::Segmenter(const Image& img, bool deterministic)
+    : image(img), width(img.width), height(img.height), deterministic(deterministic) {}
 
 //
 Image Segmenter::segmentationVisualization(const std::vector<int>& labels) {
@@ -56,53 +59,378 @@ double Segmenter::rgbDistance(const Pixel& pix_a, const Pixel& pix_b) {
 
 // Implements the Felzenszwalb graph-based segmentation algorithm.
 // 'k' controls the scale of segmentation.
-std::vector<int> Segmenter::segment(double k) {
+std::vector<int> Segmenter::segment(double k, std::vector<SegmentStats>* stats) {
+    SegmentationWorkspace workspace;
+    segment(k, workspace, stats);
+    return std::move(workspace.labels);
+}
+
+// Same algorithm, with every buffer taken from 'workspace'.
+const std::vector<int>& Segmenter::segment(double k, SegmentationWorkspace& workspace, std::vector<SegmentStats>* stats) {
+    createGraph(workspace.edges); // Get all pixel edges
+    sortEdges(workspace.edges);
+    return segmentSorted(k, workspace, stats);
+}
+
+// Felzenszwalb merging and labeling over the already sorted workspace.edges.
+const std::vector<int>& Segmenter::segmentSorted(double k, SegmentationWorkspace& workspace, std::vector<SegmentStats>* stats) {
     int total_pixels = width * height;
-    
-    std::vector<Edge> graph = createGraph(); // Get all pixel edges
-    // Sort edges by weight in ascending order
-    std::sort(graph.begin(), graph.end(), [](Edge e1, Edge e2) 
-    { return e1.weight < e2.weight; });
-    Disjoint disjoint_sets(total_pixels); // Initialize Disjoint Set Union
-
-    // Iterate through sorted edges and apply the merging criterion
-    for (const Edge& current_edge : graph) {
-        // Attempt to unite the sets of the two pixels connected by the edge.
-        // The DSU's unite_sets function internally checks the Felzenszwalb merging condition.
-
-        int root1 = disjoint_sets.find_set_root(current_edge.u); 
-        int root2 = disjoint_sets.find_set_root(current_edge.v); 
-
-        if (root1 != root2) { // if roots are different
-            // Calculate the adaptive thresholds
-            double tau1 = k / disjoint_sets.component_size[root1];
-            double tau2 = k / disjoint_sets.component_size[root2];
-
-            // Calculate the minimum internal difference (MInt)
-            double mInt = std::min(disjoint_sets.max_internal_edge[root1] + tau1, disjoint_sets.max_internal_edge[root2] + tau2);
-
-            if (current_edge.weight <= mInt) { // If the edge weight is less than or equal to MInt, merge
-                disjoint_sets.unite_sets(root1, root2, current_edge.weight);
+
+    const std::vector<Edge>& graph = workspace.edges;
+    Disjoint& disjoint_sets = workspace.disjoint_sets;
+    disjoint_sets.reset(total_pixels); // Initialize Disjoint Set Union
+    mergeComponents(graph, k, disjoint_sets);
+
+    AGM_STATS_TIMER(label_ms);
+    std::vector<int>& regions = workspace.labels;
+    regions.resize(total_pixels);
+    // Assign labels to regions using the Disjoint Set Union
+    if (stats) {
+        SegmentStatistics statistics(total_pixels);
+        for (int r = 0; r < height; ++r) {
+            for (int c = 0; c < width; ++c) {
+                int i = image.index(r, c);
+                regions[i] = disjoint_sets.find_set_root(i);
+                if (regions[i] == i) AGM_STATS_ADD(segments, 1);
+                statistics.add(regions[i], c, r, image.pixel_data[i]);
             }
         }
-
+        *stats = statistics.table();
+    } else {
+        for (int i = 0; i < total_pixels; ++i) {
+            regions[i] = disjoint_sets.find_set_root(i);
+            if (regions[i] == i) AGM_STATS_ADD(segments, 1);
+        }
     }
 
-    std::vector<int> regions(total_pixels);
-    // Assign labels to regions using the Disjoint Set Union
+    // Size and Int(C) of every segment, by label, only when resegmentRect will need them
+    if (!workspace.keep_segment_sizes) return regions;
+    workspace.segment_size.assign(total_pixels, 0);
+    workspace.segment_internal.resize(total_pixels);
     for (int i = 0; i < total_pixels; ++i) {
-        regions[i] = disjoint_sets.find_set_root(i);
+        if (regions[i] == i) {
+            workspace.segment_size[i] = disjoint_sets.component_size[i];
+            workspace.segment_internal[i] = disjoint_sets.max_internal_edge[i];
+        }
     }
 
-    std::unordered_map<int, int> region_sizes;
-    for (int region : regions) region_sizes[region]++;
-
     return regions;
 }
 
+// Re-runs the Felzenszwalb merge on the pixels of the dirty rectangle grown by 'margin' only.
+// Each segment crossing the region border enters the local graph as a single node that stands
+// for its pixels outside the region, with the size and Int(C) saved for it, so region pixels can
+// join it (and two such remnants can merge) under the usual criterion. Nothing outside the
+// region is re-weighted; pixels outside it only change label when their remnant merged.
+int Segmenter::resegmentRect(double k, std::vector<int>& labels, Rect dirty, int margin, SegmentationWorkspace& workspace) {
+    Rect region = dirty.expandedWithin(margin, width, height);
+    if (region.empty()) return 0;
+    int x0 = region.x, y0 = region.y, x1 = region.x + region.width, y1 = region.y + region.height;
+    int region_size = region.width * region.height;
+    int total_pixels = width * height;
+    if (!workspace.keep_segment_sizes || static_cast<int>(workspace.segment_size.size()) != total_pixels) {
+        std::cerr << "Error: resegmentRect needs a segment() run with keep_segment_sizes set" << std::endl;
+        return 0;
+    }
+    std::vector<int>& size = workspace.segment_size;
+    std::vector<double>& internal = workspace.segment_internal;
+
+    // 1. Labels inside the region (sorted, repeated once per pixel) and on the one-pixel ring around it
+    std::vector<int>& inside = workspace.region_labels;
+    inside.clear();
+    for (int r = y0; r < y1; ++r) {
+        for (int c = x0; c < x1; ++c) {
+            inside.push_back(labels[image.index(r, c)]);
+        }
+    }
+    std::sort(inside.begin(), inside.end());
+    auto countInside = [&](int label) {
+        auto range = std::equal_range(inside.begin(), inside.end(), label);
+        return static_cast<int>(range.second - range.first);
+    };
+
+    std::vector<int>& ring = workspace.ring_labels;
+    ring.clear();
+    for (int c = x0; c < x1; ++c) {
+        if (y0 > 0) ring.push_back(labels[image.index(y0 - 1, c)]);
+        if (y1 < height) ring.push_back(labels[image.index(y1, c)]);
+    }
+    for (int r = y0; r < y1; ++r) {
+        if (x0 > 0) ring.push_back(labels[image.index(r, x0 - 1)]);
+        if (x1 < width) ring.push_back(labels[image.index(r, x1)]);
+    }
+    std::sort(ring.begin(), ring.end());
+    ring.erase(std::unique(ring.begin(), ring.end()), ring.end());
+    int ring_count = static_cast<int>(ring.size());
+    auto ringNode = [&](int idx) {
+        return region_size + static_cast<int>(std::lower_bound(ring.begin(), ring.end(), labels[idx]) - ring.begin());
+    };
+
+    // Segments entirely inside the region are dissolved; one that only left pieces outside that
+    // do not reach the ring keeps its label for those pieces
+    for (size_t i = 0; i < inside.size(); i += countInside(inside[i])) {
+        int label = inside[i];
+        if (!std::binary_search(ring.begin(), ring.end(), label)) {
+            size[label] -= countInside(label);
+        }
+    }
+
+    // 2. Local graph: region pixels (row-major) and one node per ring segment, fresh weights
+    std::vector<Edge>& graph = workspace.region_edges;
+    graph.clear();
+    auto weight = [&](int a, int b) { return rgbDistance(image.pixel_data[a], image.pixel_data[b]); };
+    for (int r = y0; r < y1; ++r) {
+        for (int c = x0; c < x1; ++c) {
+            int idx = image.index(r, c);
+            int node = (r - y0) * region.width + (c - x0);
+            if (c + 1 < x1) {
+                graph.push_back({node, node + 1, weight(idx, idx + 1)});
+            } else if (c + 1 < width) {
+                graph.push_back({node, ringNode(idx + 1), weight(idx, idx + 1)});
+            }
+            if (r + 1 < y1) {
+                graph.push_back({node, node + region.width, weight(idx, idx + width)});
+            } else if (r + 1 < height) {
+                graph.push_back({node, ringNode(idx + width), weight(idx, idx + width)});
+            }
+            if (c == x0 && c > 0) graph.push_back({ringNode(idx - 1), node, weight(idx - 1, idx)});
+            if (r == y0 && r > 0) graph.push_back({ringNode(idx - width), node, weight(idx - width, idx)});
+        }
+    }
+    sortEdges(graph);
+
+    Disjoint& disjoint_sets = workspace.region_sets;
+    disjoint_sets.reset(region_size + ring_count);
+    std::vector<int>& remnant = workspace.ring_sizes;
+    remnant.resize(ring_count);
+    for (int j = 0; j < ring_count; ++j) {
+        remnant[j] = std::max(1, size[ring[j]] - countInside(ring[j]));
+        disjoint_sets.component_size[region_size + j] = remnant[j];
+        disjoint_sets.max_internal_edge[region_size + j] = internal[ring[j]];
+    }
+    mergeComponents(graph, k, disjoint_sets);
+
+    // 3. Each component with ring segments keeps the label of its largest remnant; the others are
+    // relabelled by a flood fill outside the region, starting from the ring
+    std::vector<int>& root_label = workspace.region_pixels;
+    root_label.assign(region_size + ring_count, -1);
+    for (int j = 0; j < ring_count; ++j) {
+        int root = disjoint_sets.find_set_root(region_size + j);
+        int owner = root_label[root];
+        if (owner < 0 || remnant[j] > remnant[std::lower_bound(ring.begin(), ring.end(), owner) - ring.begin()]) {
+            root_label[root] = ring[j];
+        }
+    }
+
+    int relabelled = 0;
+    std::vector<int>& queue = workspace.region_queue;
+    for (int j = 0; j < ring_count; ++j) {
+        int root = disjoint_sets.find_set_root(region_size + j);
+        int from = ring[j], to = root_label[root];
+        if (from == to) continue;
+        queue.clear();
+        auto visit = [&](int r, int c) {
+            if (r >= y0 && r < y1 && c >= x0 && c < x1) return;
+            int idx = image.index(r, c);
+            if (labels[idx] == from) {
+                labels[idx] = to;
+                queue.push_back(idx);
+            }
+        };
+        for (int c = x0; c < x1; ++c) {
+            if (y0 > 0) visit(y0 - 1, c);
+            if (y1 < height) visit(y1, c);
+        }
+        for (int r = y0; r < y1; ++r) {
+            if (x0 > 0) visit(r, x0 - 1);
+            if (x1 < width) visit(r, x1);
+        }
+        for (size_t i = 0; i < queue.size(); ++i) {
+            int r = queue[i] / width, c = queue[i] % width;
+            if (c > 0) visit(r, c - 1);
+            if (c + 1 < width) visit(r, c + 1);
+            if (r > 0) visit(r - 1, c);
+            if (r + 1 < height) visit(r + 1, c);
+        }
+        // Pieces of the remnant the fill did not reach stay separate under the old label
+        int leftover = remnant[j] - static_cast<int>(queue.size());
+        size[from] = std::max(0, leftover);
+        disjoint_sets.component_size[root] -= std::max(0, leftover);
+        relabelled += static_cast<int>(queue.size());
+    }
+    for (int j = 0; j < ring_count; ++j) {
+        int root = disjoint_sets.find_set_root(region_size + j);
+        if (root_label[root] == ring[j]) {
+            size[ring[j]] = disjoint_sets.component_size[root];
+            internal[ring[j]] = disjoint_sets.max_internal_edge[root];
+        }
+    }
+
+    // 4. New segments take the pixel index of their root as label when it is free, else the next free label
+    int& free_label = workspace.free_label;
+    for (int r = y0; r < y1; ++r) {
+        for (int c = x0; c < x1; ++c) {
+            int root = disjoint_sets.find_set_root((r - y0) * region.width + (c - x0));
+            if (root_label[root] < 0) {
+                int label = image.index(y0 + root / region.width, x0 + root % region.width);
+                while (size[label] != 0) {
+                    label = free_label;
+                    free_label = (free_label + 1) % total_pixels;
+                }
+                root_label[root] = label;
+                size[label] = disjoint_sets.component_size[root];
+                internal[label] = disjoint_sets.max_internal_edge[root];
+            }
+            labels[image.index(r, c)] = root_label[root];
+        }
+    }
+    return region_size + relabelled;
+}
+
+// Sorts edges by weight in ascending order.
+void Segmenter::sortEdges(std::vector<Edge>& edges) const {
+    AGM_STATS_TIMER(sort_ms);
+    std::sort(edges.begin(), edges.end(), [this](const Edge& a, const Edge& b) { return edgeLess(a, b); });
+}
+
+// Recomputes the weights of edges sorted for a previous image. An edge stays in place if its new
+// weight keeps it in order: unchanged weights always do, and so does a lower weight that is still
+// not below the last kept edge (it can never block the unchanged edges after it). All other edges
+// are moved aside, sorted and merged back.
+double Segmenter::updateSortedEdges(std::vector<Edge>& edges, SegmentationWorkspace& workspace, double max_dropped_fraction) {
+    AGM_STATS_TIMER(sort_ms);
+    auto less = [this](const Edge& a, const Edge& b) { return edgeLess(a, b); };
+    std::vector<Edge>& dropped = workspace.edges_dropped;
+    dropped.clear();
+    size_t max_dropped = static_cast<size_t>(max_dropped_fraction * edges.size());
+    size_t kept = 0;
+    bool fall_back = false;
+
+    for (size_t i = 0; i < edges.size(); ++i) {
+        Edge edge = edges[i];
+        double old_weight = edge.weight;
+        edge.weight = rgbDistance(image.pixel_data[edge.u], image.pixel_data[edge.v]);
+
+        if (edge.weight <= old_weight && (kept == 0 || !edgeLess(edge, edges[kept - 1]))) {
+            edges[kept++] = edge;
+        } else if (!fall_back) {
+            dropped.push_back(edge);
+            fall_back = dropped.size() > max_dropped;
+        } else {
+            edges[kept++] = edge; // Order no longer matters, everything gets sorted
+        }
+    }
+
+    double fraction = edges.empty() ? 0.0 : static_cast<double>(dropped.size()) / edges.size();
+    if (fall_back) { // Too far from sorted: sort everything
+        std::copy(dropped.begin(), dropped.end(), edges.begin() + kept);
+        std::sort(edges.begin(), edges.end(), less);
+        return fraction;
+    }
+
+    std::sort(dropped.begin(), dropped.end(), less);
+    std::vector<Edge>& merged = workspace.edges_merged;
+    merged.resize(edges.size());
+    std::merge(edges.begin(), edges.begin() + kept, dropped.begin(), dropped.end(), merged.begin(), less);
+    edges.swap(merged);
+    return fraction;
+}
+
+// Merges the components of pixels 'u' and 'v' if the edge weight does not exceed
+// their minimum internal difference (MInt).
+static void mergeEdge(int u, int v, double weight, double k, Disjoint& disjoint_sets) {
+    int root1 = disjoint_sets.find_set_root(u);
+    int root2 = disjoint_sets.find_set_root(v);
+
+    if (root1 != root2) { // if roots are different
+        // Calculate the adaptive thresholds
+        double tau1 = k / disjoint_sets.component_size[root1];
+        double tau2 = k / disjoint_sets.component_size[root2];
+
+        // Calculate the minimum internal difference (MInt)
+        double mInt = std::min(disjoint_sets.max_internal_edge[root1] + tau1, disjoint_sets.max_internal_edge[root2] + tau2);
+
+        if (weight <= mInt) { // If the edge weight is less than or equal to MInt, merge
+            disjoint_sets.unite_sets(root1, root2, weight);
+            AGM_STATS_ADD(merges, 1);
+        }
+    }
+}
+
+// Iterates through sorted edges and merges components whose connecting edge
+// does not exceed their minimum internal difference (MInt).
+void Segmenter::mergeComponents(const std::vector<Edge>& sorted_edges, double k, Disjoint& disjoint_sets) {
+    AGM_STATS_TIMER(merge_ms);
+    for (const Edge& current_edge : sorted_edges) {
+        mergeEdge(current_edge.u, current_edge.v, current_edge.weight, k, disjoint_sets);
+    }
+}
+
+// Squared RGB distance, an exact integer; its square root is rgbDistance.
+static uint32_t squaredDistance(const Pixel& a, const Pixel& b) {
+    int dr = a.r - b.r, dg = a.g - b.g, db = a.b - b.b;
+    return static_cast<uint32_t>(dr * dr + dg * dg + db * db);
+}
+
+// Edges are packed as (squared distance << 32) | (2 * pixel + direction), direction 0 being the right
+// neighbour and 1 the one below. Sorting the keys as integers orders edges by weight, then by (u, v).
+std::vector<int> Segmenter::segmentCompact(double k) {
+    int total_pixels = width * height;
+    std::vector<uint64_t> edges;
+    {
+        AGM_STATS_TIMER(graph_ms);
+        edges.reserve(2 * static_cast<size_t>(total_pixels));
+        for (int r = 0; r < height; ++r) {
+            for (int c = 0; c < width; ++c) {
+                int idx = image.index(r, c);
+                uint64_t code = 2 * static_cast<uint64_t>(idx);
+                if (c + 1 < width) {
+                    edges.push_back(static_cast<uint64_t>(squaredDistance(image.pixel_data[idx], image.pixel_data[idx + 1])) << 32 | code);
+                }
+                if (r + 1 < height) {
+                    edges.push_back(static_cast<uint64_t>(squaredDistance(image.pixel_data[idx], image.pixel_data[idx + width])) << 32 | (code + 1));
+                }
+            }
+        }
+        AGM_STATS_ADD(edges, edges.size());
+    }
+    {
+        AGM_STATS_TIMER(sort_ms);
+        std::sort(edges.begin(), edges.end());
+    }
+
+    Disjoint disjoint_sets(total_pixels);
+    {
+        AGM_STATS_TIMER(merge_ms);
+        for (uint64_t edge : edges) {
+            uint32_t code = static_cast<uint32_t>(edge);
+            int u = static_cast<int>(code >> 1);
+            int v = (code & 1) ? u + width : u + 1;
+            mergeEdge(u, v, std::sqrt(static_cast<double>(edge >> 32)), k, disjoint_sets);
+        }
+    }
+    std::vector<uint64_t>().swap(edges);
+
+    AGM_STATS_TIMER(label_ms);
+    std::vector<int> labels(total_pixels);
+    for (int i = 0; i < total_pixels; ++i) {
+        labels[i] = disjoint_sets.find_set_root(i);
+        if (labels[i] == i) AGM_STATS_ADD(segments, 1);
+    }
+    return labels;
+}
+
 // Builds a graph, vector of all edges between 4-connected neighboring pixels.
 std::vector<Edge> Segmenter::createGraph() {
     std::vector<Edge> edges_list;
+    createGraph(edges_list);
+    return edges_list;
+}
+
+// Fills 'edges_list' (cleared first, capacity kept) with all edges between 4-connected neighboring pixels.
+void Segmenter::createGraph(std::vector<Edge>& edges_list) {
+    AGM_STATS_TIMER(graph_ms);
+    edges_list.clear();
     for (int r = 0; r < height; ++r) {
         for (int c = 0; c < width; ++c) {
             int current_pixel_idx = image.index(r, c);
@@ -119,5 +447,5 @@ std::vector<Edge> Segmenter::createGraph() {
             }
         }
     }
-    return edges_list;
+    AGM_STATS_ADD(edges, edges_list.size());
 }
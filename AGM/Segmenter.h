@@ -5,6 +5,9 @@
 #include "Pixel.h"
 #include "Edge.h"
 #include "Disjoint.h"
+#include "SegmentStats.h"
+#include "SegmentationWorkspace.h"
+#include "Rect.h"
 
 #include <vector>
 #include <queue>
@@ -15,9 +18,12 @@ public:
     const Image& image; // Reference to the input image
     int width;           // Image width
     int height;          // Image height
+    bool deterministic;  // Orders edges of equal weight by (u, v), see edgeLess
 
     // Constructor: Initializes the segmenter with the input image.
-    Segmenter(const Image& img);
+    // In deterministic mode the merge order, and the labels, do not depend on the sort
+    // implementation or on the order the edges were produced in.
+    Segmenter(const Image& img, bool deterministic = false);
 
     // Calculates the color difference between two pixels (used by Felzenszwalb).
     double rgbDistance(const Pixel& a, const Pixel& b);
@@ -26,14 +32,60 @@ public:
     // Uses 4-connectivity (horizontal and vertical neighbors).
     std::vector<Edge> createGraph();
 
+    // Same, filling 'edges' in place (cleared first; its capacity is reused).
+    void createGraph(std::vector<Edge>& edges);
+
+    // Sorts edges by weight in ascending order (see edgeLess).
+    void sortEdges(std::vector<Edge>& edges) const;
+
+    // Edge order used by every sort and merge of sorted edges: by weight, then by (u, v) in deterministic mode.
+    bool edgeLess(const Edge& e1, const Edge& e2) const {
+        if (e1.weight != e2.weight || !deterministic) return e1.weight < e2.weight;
+        return e1.u != e2.u ? e1.u < e2.u : e1.v < e2.v;
+    }
+
+    // Recomputes the weights of 'edges', sorted for a previous image of the same size (e.g. the
+    // previous video frame), and restores the order in O(n + d log d), where d is the number of
+    // edges that moved out of order. Falls back to a full sort once more than 'max_dropped_fraction'
+    // of the edges moved. Uses the scratch vectors of 'workspace'. Returns the fraction that moved
+    // (at least 'max_dropped_fraction' after a fallback).
+    double updateSortedEdges(std::vector<Edge>& edges, SegmentationWorkspace& workspace, double max_dropped_fraction);
+
+    // Applies the Felzenszwalb merging criterion to 'sorted_edges', uniting components in 'disjoint_sets'.
+    static void mergeComponents(const std::vector<Edge>& sorted_edges, double k, Disjoint& disjoint_sets);
+
     // Performs image segmentation using the Felzenszwalb algorithm.
     // 'k' is the scale parameter.
-    std::vector<int> segment(double k);
+    // If 'stats' is given, it receives the per-segment statistics table, accumulated during the labeling pass.
+    std::vector<int> segment(double k, std::vector<SegmentStats>* stats = nullptr);
+
+    // Same, using the buffers of 'workspace' (no allocations once it has been used for an image
+    // of this size, unless 'stats' is requested). Returns workspace.labels.
+    const std::vector<int>& segment(double k, SegmentationWorkspace& workspace, std::vector<SegmentStats>* stats = nullptr);
+
+    // Incremental update of 'labels' after the pixels inside 'dirty' changed. 'labels' must come from
+    // segment(k, workspace) on this workspace with workspace.keep_segment_sizes set (or from earlier
+    // resegmentRect calls on it), which leaves the size and Int(C) of every segment in
+    // workspace.segment_size / segment_internal.
+    // Only pixels inside 'dirty' grown by 'margin' are dissolved and re-weighted. Each segment
+    // reaching the region border takes part as one node with its saved size and Int(C) less the
+    // dissolved pixels, so it can absorb new pixels or merge with another such segment; the
+    // smaller one is then relabelled outside the region. Cost follows the region size plus the
+    // relabelled pixels. Boundaries beyond the region, and the merge order, may differ from a
+    // full re-run. 'margin' should be at least the blur radius if the image is blurred.
+    // Returns the number of pixels that were re-labelled.
+    int resegmentRect(double k, std::vector<int>& labels, Rect dirty, int margin, SegmentationWorkspace& workspace);
+
+    // Lower-memory segment(): edges are packed into 8 bytes instead of 16 and sorted as integer keys
+    // (squared distance, then pixel index). Gives the same labels as segment() in deterministic mode.
+    std::vector<int> segmentCompact(double k);
+
+    // Merges and labels using the edges already sorted in workspace.edges (skips graph construction and sorting).
+    const std::vector<int>& segmentSorted(double k, SegmentationWorkspace& workspace, std::vector<SegmentStats>* stats = nullptr);
 
     // Visualizes the segmentation by assigning random colors to each segment.
     // Returns a new Image object with the colored segments.
     Image segmentationVisualization(const std::vector<int>& labels);
-
 };
 
 #endif // SEGMENTER_H
\ No newline at end of file
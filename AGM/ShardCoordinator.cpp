@@ -0,0 +1,358 @@
+#include "ShardCoordinator.h"
+#include "Segmenter.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+std::vector<Rect> ShardCoordinator::makeTiles(int width, int height, int tile_size) {
+    std::vector<Rect> tiles;
+    for (int y = 0; y < height; y += tile_size) {
+        for (int x = 0; x < width; x += tile_size) {
+            tiles.push_back({x, y, std::min(tile_size, width - x), std::min(tile_size, height - y)});
+        }
+    }
+    return tiles;
+}
+
+TileResult ShardCoordinator::segmentTile(const Image& image, Rect rect, double k, bool deterministic, SegmentationWorkspace& workspace) {
+    Image tile(rect.width, rect.height);
+    for (int r = 0; r < rect.height; ++r) {
+        std::copy_n(image.pixel_data.begin() + image.index(rect.y + r, rect.x), rect.width,
+                    tile.pixel_data.begin() + tile.index(r, 0));
+    }
+
+    Segmenter segmenter(tile, deterministic);
+    TileResult result;
+    result.rect = rect;
+    result.labels = segmenter.segment(k, workspace);
+
+    // Components on the tile border, in root order
+    std::vector<int>& roots = workspace.region_labels;
+    roots.clear();
+    for (int c = 0; c < rect.width; ++c) {
+        roots.push_back(result.labels[tile.index(0, c)]);
+        roots.push_back(result.labels[tile.index(rect.height - 1, c)]);
+    }
+    for (int r = 0; r < rect.height; ++r) {
+        roots.push_back(result.labels[tile.index(r, 0)]);
+        roots.push_back(result.labels[tile.index(r, rect.width - 1)]);
+    }
+    std::sort(roots.begin(), roots.end());
+    roots.erase(std::unique(roots.begin(), roots.end()), roots.end());
+    for (int root : roots) {
+        result.border.push_back({root, workspace.disjoint_sets.component_size[root], workspace.disjoint_sets.max_internal_edge[root]});
+    }
+    return result;
+}
+
+template <typename T>
+static void append(std::vector<unsigned char>& out, const T& value) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+static bool take(const unsigned char* data, size_t size, size_t& offset, T& value) {
+    if (size - offset < sizeof(T)) return false;
+    std::memcpy(&value, data + offset, sizeof(T));
+    offset += sizeof(T);
+    return true;
+}
+
+void ShardCoordinator::serialize(const TileResult& result, std::vector<unsigned char>& out) {
+    append<int32_t>(out, result.tile_index);
+    append<int32_t>(out, result.rect.x);
+    append<int32_t>(out, result.rect.y);
+    append<int32_t>(out, result.rect.width);
+    append<int32_t>(out, result.rect.height);
+    const unsigned char* labels = reinterpret_cast<const unsigned char*>(result.labels.data());
+    out.insert(out.end(), labels, labels + result.labels.size() * sizeof(int32_t));
+    append<uint32_t>(out, static_cast<uint32_t>(result.border.size()));
+    for (const TileComponent& component : result.border) {
+        append<int32_t>(out, component.root);
+        append<int32_t>(out, component.size);
+        append<double>(out, component.max_internal_edge);
+    }
+}
+
+bool ShardCoordinator::deserialize(const unsigned char* data, size_t size, TileResult& result, size_t& consumed) {
+    size_t offset = 0;
+    int32_t index, x, y, width, height;
+    if (!take(data, size, offset, index) || !take(data, size, offset, x) || !take(data, size, offset, y) ||
+        !take(data, size, offset, width) || !take(data, size, offset, height) || width < 0 || height < 0) {
+        return false;
+    }
+    size_t label_bytes = static_cast<size_t>(width) * height * sizeof(int32_t);
+    if (size - offset < label_bytes) return false;
+    result.tile_index = index;
+    result.rect = {x, y, width, height};
+    result.labels.resize(static_cast<size_t>(width) * height);
+    std::memcpy(result.labels.data(), data + offset, label_bytes);
+    offset += label_bytes;
+
+    uint32_t count;
+    if (!take(data, size, offset, count)) return false;
+    result.border.resize(count);
+    for (TileComponent& component : result.border) {
+        int32_t root, component_size;
+        double max_internal_edge;
+        if (!take(data, size, offset, root) || !take(data, size, offset, component_size) ||
+            !take(data, size, offset, max_internal_edge)) {
+            return false;
+        }
+        component = {root, component_size, max_internal_edge};
+    }
+    consumed = offset;
+    return true;
+}
+
+// Decodes every result in 'buffer' into 'results' (indexed by tile). Returns false on malformed data.
+static bool collectResults(const std::vector<unsigned char>& buffer, std::vector<TileResult>& results) {
+    size_t offset = 0;
+    while (offset < buffer.size()) {
+        TileResult result;
+        size_t consumed = 0;
+        if (!ShardCoordinator::deserialize(buffer.data() + offset, buffer.size() - offset, result, consumed) ||
+            result.tile_index < 0 || result.tile_index >= static_cast<int>(results.size())) {
+            return false;
+        }
+        offset += consumed;
+        results[result.tile_index] = std::move(result);
+    }
+    return true;
+}
+
+bool LocalTransport::run(const Image& image, const std::vector<Rect>& tiles, double k, std::vector<TileResult>& results) {
+    // Each result goes through the wire format on its own, so only one tile is ever serialized
+    SegmentationWorkspace workspace;
+    std::vector<unsigned char> buffer;
+    results.assign(tiles.size(), TileResult());
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        TileResult result = ShardCoordinator::segmentTile(image, tiles[i], k, deterministic, workspace);
+        result.tile_index = static_cast<int>(i);
+        buffer.clear();
+        ShardCoordinator::serialize(result, buffer);
+        if (!collectResults(buffer, results)) return false;
+    }
+    return true;
+}
+
+// Writes all of 'size' bytes to 'fd'.
+static bool writeAll(int fd, const unsigned char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+// Reads every pipe in 'fds' until end of file, appending to the matching entry of 'buffers'. All
+// pipes are polled together: a tile result is larger than a pipe buffer, so reading one pipe at a
+// time would leave the other workers blocked in write() until their turn. Closes each pipe at its
+// end of file (or read error) and sets its entry in 'fds' to -1. Returns false if a read failed.
+static bool readAll(std::vector<int>& fds, std::vector<std::vector<unsigned char>>& buffers) {
+    std::vector<pollfd> polled(fds.size());
+    for (size_t w = 0; w < fds.size(); ++w) polled[w] = {fds[w], POLLIN, 0};
+    size_t open = fds.size();
+    bool ok = true;
+    unsigned char chunk[1 << 16];
+    while (open > 0) {
+        if (poll(polled.data(), polled.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            ok = false;
+            break;
+        }
+        for (size_t w = 0; w < polled.size(); ++w) {
+            if (polled[w].fd < 0 || polled[w].revents == 0) continue;
+            ssize_t got = read(polled[w].fd, chunk, sizeof(chunk));
+            if (got < 0 && errno == EINTR) continue;
+            if (got > 0) {
+                buffers[w].insert(buffers[w].end(), chunk, chunk + got);
+                continue;
+            }
+            if (got < 0) ok = false;
+            close(polled[w].fd);
+            polled[w].fd = fds[w] = -1; // poll() skips negative descriptors
+            --open;
+        }
+    }
+    for (int& fd : fds) {
+        if (fd >= 0) close(fd);
+        fd = -1;
+    }
+    return ok;
+}
+
+bool ProcessTransport::run(const Image& image, const std::vector<Rect>& tiles, double k, std::vector<TileResult>& results) {
+    int worker_count = std::max(1, std::min(workers, static_cast<int>(tiles.size())));
+    std::vector<pid_t> pids;
+    std::vector<int> fds;
+    bool ok = true;
+
+    for (int w = 0; w < worker_count; ++w) {
+        int channel[2];
+        if (pipe(channel) != 0) {
+            std::cerr << "Error: could not create a pipe for worker " << w << std::endl;
+            ok = false;
+            break;
+        }
+        pid_t pid = fork();
+        if (pid < 0) {
+            std::cerr << "Error: could not start worker " << w << std::endl;
+            close(channel[0]);
+            close(channel[1]);
+            ok = false;
+            break;
+        }
+        if (pid == 0) {
+            // Worker: the read ends inherited from earlier workers are not ours
+            close(channel[0]);
+            for (int fd : fds) close(fd);
+            Parallel::setThreadCount(1); // The processes are the parallelism; the parent's pool threads do not exist here
+            SegmentationWorkspace workspace;
+            std::vector<unsigned char> buffer;
+            for (size_t i = w; i < tiles.size(); i += worker_count) {
+                TileResult result = ShardCoordinator::segmentTile(image, tiles[i], k, deterministic, workspace);
+                result.tile_index = static_cast<int>(i);
+                buffer.clear();
+                ShardCoordinator::serialize(result, buffer);
+                if (!writeAll(channel[1], buffer.data(), buffer.size())) _exit(1);
+            }
+            close(channel[1]);
+            _exit(0);
+        }
+        close(channel[1]);
+        pids.push_back(pid);
+        fds.push_back(channel[0]);
+    }
+
+    // All workers are drained at once, each into its own buffer, then decoded
+    results.assign(tiles.size(), TileResult());
+    std::vector<std::vector<unsigned char>> buffers(fds.size());
+    if (!readAll(fds, buffers)) {
+        std::cerr << "Error: could not read the worker replies" << std::endl;
+        ok = false;
+    }
+    for (size_t w = 0; w < buffers.size(); ++w) {
+        if (!collectResults(buffers[w], results)) {
+            std::cerr << "Error: bad reply from worker " << w << std::endl;
+            ok = false;
+        }
+    }
+    for (size_t w = 0; w < pids.size(); ++w) {
+        int status = 0;
+        if (waitpid(pids[w], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            std::cerr << "Error: worker " << w << " failed" << std::endl;
+            ok = false;
+        }
+    }
+    for (const TileResult& result : results) {
+        if (result.tile_index < 0) ok = false; // A tile was never returned
+    }
+    return ok;
+}
+
+std::vector<int> ShardCoordinator::stitch(const Image& image, const std::vector<TileResult>& results, int tile_size, double k) {
+    int width = image.width;
+    int height = image.height;
+    int tiles_x = (width + tile_size - 1) / tile_size;
+
+    // Border components of all tiles get consecutive ids, in tile order
+    std::vector<int> first_component(results.size() + 1, 0);
+    for (size_t t = 0; t < results.size(); ++t) {
+        first_component[t + 1] = first_component[t] + static_cast<int>(results[t].border.size());
+    }
+    Disjoint components(first_component.back());
+    for (size_t t = 0; t < results.size(); ++t) {
+        for (size_t j = 0; j < results[t].border.size(); ++j) {
+            int id = first_component[t] + static_cast<int>(j);
+            components.component_size[id] = results[t].border[j].size;
+            components.max_internal_edge[id] = results[t].border[j].max_internal_edge;
+        }
+    }
+
+    // Border component id of the pixel at row r, column c (which lies on its tile border)
+    auto componentAt = [&](int r, int c) {
+        int t = (r / tile_size) * tiles_x + c / tile_size;
+        const TileResult& tile = results[t];
+        int root = tile.labels[(r - tile.rect.y) * tile.rect.width + (c - tile.rect.x)];
+        auto it = std::lower_bound(tile.border.begin(), tile.border.end(), root,
+                                   [](const TileComponent& component, int value) { return component.root < value; });
+        return first_component[t] + static_cast<int>(it - tile.border.begin());
+    };
+
+    // Seam edges between horizontally and vertically adjacent tiles
+    Segmenter segmenter(image);
+    std::vector<Edge> seams;
+    for (int c = tile_size; c < width; c += tile_size) {
+        for (int r = 0; r < height; ++r) {
+            seams.push_back({componentAt(r, c - 1), componentAt(r, c),
+                             segmenter.rgbDistance(image.pixel_data[image.index(r, c - 1)], image.pixel_data[image.index(r, c)])});
+        }
+    }
+    for (int r = tile_size; r < height; r += tile_size) {
+        for (int c = 0; c < width; ++c) {
+            seams.push_back({componentAt(r - 1, c), componentAt(r, c),
+                             segmenter.rgbDistance(image.pixel_data[image.index(r - 1, c)], image.pixel_data[image.index(r, c)])});
+        }
+    }
+    // Total order, so equal weights are always merged in the same sequence
+    std::sort(seams.begin(), seams.end(), [](const Edge& a, const Edge& b) {
+        if (a.weight != b.weight) return a.weight < b.weight;
+        if (a.u != b.u) return a.u < b.u;
+        return a.v < b.v;
+    });
+    Segmenter::mergeComponents(seams, k, components);
+
+    // Each stitched segment is labelled by the smallest global root index among its parts
+    auto globalRoot = [&](size_t t, int root) {
+        const Rect& rect = results[t].rect;
+        return image.index(rect.y + root / rect.width, rect.x + root % rect.width);
+    };
+    std::vector<int> representative(first_component.back(), -1);
+    for (size_t t = 0; t < results.size(); ++t) {
+        for (size_t j = 0; j < results[t].border.size(); ++j) {
+            int set = components.find_set_root(first_component[t] + static_cast<int>(j));
+            int global = globalRoot(t, results[t].border[j].root);
+            if (representative[set] == -1 || global < representative[set]) representative[set] = global;
+        }
+    }
+
+    std::vector<int> labels(static_cast<size_t>(width) * height);
+    for (size_t t = 0; t < results.size(); ++t) {
+        const TileResult& tile = results[t];
+        for (int r = 0; r < tile.rect.height; ++r) {
+            for (int c = 0; c < tile.rect.width; ++c) {
+                int root = tile.labels[r * tile.rect.width + c];
+                auto it = std::lower_bound(tile.border.begin(), tile.border.end(), root,
+                                           [](const TileComponent& component, int value) { return component.root < value; });
+                bool on_border = it != tile.border.end() && it->root == root;
+                labels[image.index(tile.rect.y + r, tile.rect.x + c)] = on_border
+                    ? representative[components.find_set_root(first_component[t] + static_cast<int>(it - tile.border.begin()))]
+                    : globalRoot(t, root);
+            }
+        }
+    }
+    return labels;
+}
+
+bool ShardCoordinator::segment(const Image& image, double k, int tile_size, ShardTransport& transport, std::vector<int>& labels) {
+    std::vector<Rect> tiles = makeTiles(image.width, image.height, tile_size);
+    std::vector<TileResult> results;
+    if (!transport.run(image, tiles, k, results)) {
+        return false;
+    }
+    labels = stitch(image, results, tile_size, k);
+    return true;
+}
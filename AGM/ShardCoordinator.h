@@ -0,0 +1,81 @@
+#ifndef SHARD_COORDINATOR_H
+#define SHARD_COORDINATOR_H
+
+#include <cstddef>
+#include <vector>
+#include "Image.h"
+#include "Rect.h"
+#include "SegmentationWorkspace.h"
+
+// State of a tile component that touches the tile border, needed to stitch it with its neighbours.
+struct TileComponent {
+    int root;                 // Tile-local root pixel index
+    int size;                 // Number of pixels
+    double max_internal_edge; // Internal difference Int(C)
+};
+
+// Result of segmenting one tile, as sent back by a worker.
+struct TileResult {
+    int tile_index = -1;
+    Rect rect{0, 0, 0, 0};
+    std::vector<int> labels;            // Tile-local root pixel index of every pixel in 'rect' (row-major)
+    std::vector<TileComponent> border;  // Border components, sorted by root
+};
+
+// Runs the tile segmentations somewhere and collects the results.
+class ShardTransport {
+public:
+    virtual ~ShardTransport() = default;
+
+    bool deterministic = false; // Tiles are segmented in Segmenter's deterministic mode
+
+    // Segments every tile of 'tiles' (a blurred 'image' and scale 'k') and stores the results in
+    // 'results', indexed by tile. Returns false if a worker failed.
+    virtual bool run(const Image& image, const std::vector<Rect>& tiles, double k, std::vector<TileResult>& results) = 0;
+};
+
+// In-process stand-in: segments the tiles sequentially, but still passes every result through
+// the wire format, so it behaves like the multi-process transport.
+class LocalTransport : public ShardTransport {
+public:
+    bool run(const Image& image, const std::vector<Rect>& tiles, double k, std::vector<TileResult>& results) override;
+};
+
+// Forks 'workers' processes that share the image copy-on-write. Worker w segments tiles w, w + workers, ...
+// and streams the results back through a pipe.
+class ProcessTransport : public ShardTransport {
+public:
+    explicit ProcessTransport(int workers) : workers(workers) {}
+
+    bool run(const Image& image, const std::vector<Rect>& tiles, double k, std::vector<TileResult>& results) override;
+
+private:
+    int workers;
+};
+
+// Splits an image into tiles, segments them through a ShardTransport and stitches the seams
+// with the Felzenszwalb MInt rule, using each border component's size and internal difference.
+// The result does not depend on the transport or on the number of workers.
+class ShardCoordinator {
+public:
+    // Grid of tile_size x tile_size tiles in row-major order (smaller at the right and bottom edges).
+    static std::vector<Rect> makeTiles(int width, int height, int tile_size);
+
+    // Segments the pixels of 'rect' on their own (worker side).
+    static TileResult segmentTile(const Image& image, Rect rect, double k, bool deterministic, SegmentationWorkspace& workspace);
+
+    // Wire format (native byte order): i32 tile index | i32 x, y, width, height | i32 labels[width * height]
+    // | u32 border count | (i32 root, i32 size, f64 max_internal_edge) per border component.
+    static void serialize(const TileResult& result, std::vector<unsigned char>& out);
+    // Reads one result from 'data'; stores the number of bytes used in 'consumed'. Returns false if truncated.
+    static bool deserialize(const unsigned char* data, size_t size, TileResult& result, size_t& consumed);
+
+    // Merges the tile results across the seams. 'results' must come from makeTiles(..., tile_size).
+    // Labels are global root pixel indices: the smallest one among the tile roots of a stitched segment.
+    static std::vector<int> stitch(const Image& image, const std::vector<TileResult>& results, int tile_size, double k);
+
+    // makeTiles + transport.run + stitch. Returns false if the transport failed.
+    static bool segment(const Image& image, double k, int tile_size, ShardTransport& transport, std::vector<int>& labels);
+};
+
+#endif // SHARD_COORDINATOR_H
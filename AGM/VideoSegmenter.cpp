@@ -0,0 +1,137 @@
+#include "VideoSegmenter.h"
+#include "GaussianBlur.h"
+#include "Segmenter.h"
+#include <chrono>
+
+VideoSegmenter::VideoSegmenter(double k, float sigma, bool temporal_labels, bool deterministic)
+    : k(k), sigma(sigma), temporal_labels(temporal_labels), deterministic(deterministic) {}
+
+const std::vector<int>& VideoSegmenter::segmentFrame(Image& frame) {
+    auto start = std::chrono::steady_clock::now();
+    bool warm = info.index >= 0 && frame.width == width && frame.height == height;
+    width = frame.width;
+    height = frame.height;
+    info.index++;
+
+    GaussianBlur::applyGaussianBlurToImage(frame, sigma, workspace.blur);
+    Segmenter segmenter(frame, deterministic);
+
+    if (warm) {
+        // Same edges as the previous frame, in its sorted order: only the weights change
+        info.dropped_fraction = segmenter.updateSortedEdges(workspace.edges, workspace, max_dropped_fraction);
+        info.incremental_sort = info.dropped_fraction <= max_dropped_fraction;
+    } else {
+        segmenter.createGraph(workspace.edges);
+        segmenter.sortEdges(workspace.edges);
+        info.dropped_fraction = 1.0;
+        info.incremental_sort = false;
+    }
+    segmenter.segmentSorted(k, workspace);
+
+    if (temporal_labels) {
+        if (!warm) {
+            size_t pixels = static_cast<size_t>(width) * height;
+            labels.clear(); // No reference frame
+            vote_label.assign(pixels, 0);
+            segment_size.assign(pixels, 0);
+            segment_end.assign(pixels, 0);
+            segment_pixels.assign(pixels, 0);
+            label_count.assign(pixels, 0);
+            owner.assign(pixels, -1);
+            used_stamp.assign(pixels, -1);
+            fresh_cursor = 0;
+        }
+        carryLabelsForward();
+    } else {
+        labels.swap(workspace.labels);
+    }
+
+    info.segments = 0;
+    for (int i = 0; i < width * height; ++i) {
+        if (workspace.disjoint_sets.parent[i] == i) info.segments++;
+    }
+    info.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return labels;
+}
+
+void VideoSegmenter::carryLabelsForward() {
+    const std::vector<int>& roots = workspace.labels;
+    const std::vector<int>& sizes = workspace.disjoint_sets.component_size;
+    int pixels = width * height;
+    int frame = info.index;
+
+    labels.swap(previous_labels); // Last frame's output becomes the reference
+    labels.resize(pixels);
+
+    if (previous_labels.size() != labels.size()) {
+        // Cold start: the roots themselves become the labels
+        for (int i = 0; i < pixels; ++i) {
+            labels[i] = roots[i];
+            if (roots[i] == i) used_stamp[i] = frame;
+        }
+        return;
+    }
+
+    // 1. Plurality vote of the previous labels under each segment. The pixels are grouped by segment
+    // (counting sort on the root), then each group is counted in label_count and cleared again.
+    for (int i = 0; i < pixels; ++i) {
+        if (roots[i] == i) segment_size[i] = 0;
+    }
+    for (int i = 0; i < pixels; ++i) {
+        segment_size[roots[i]]++;
+    }
+    int offset = 0;
+    for (int i = 0; i < pixels; ++i) {
+        if (roots[i] != i) continue;
+        segment_end[i] = offset;
+        offset += segment_size[i];
+    }
+    for (int i = 0; i < pixels; ++i) {
+        segment_pixels[segment_end[roots[i]]++] = i;
+    }
+    for (int i = 0; i < pixels; ++i) {
+        if (roots[i] != i) continue;
+        int begin = segment_end[i] - segment_size[i], end = segment_end[i];
+        int best = -1, best_count = 0;
+        for (int j = begin; j < end; ++j) {
+            int previous = previous_labels[segment_pixels[j]];
+            int count = ++label_count[previous];
+            if (count > best_count) { // Ties go to the label that reached the count first
+                best = previous;
+                best_count = count;
+            }
+        }
+        for (int j = begin; j < end; ++j) {
+            label_count[previous_labels[segment_pixels[j]]] = 0;
+        }
+        vote_label[i] = best;
+    }
+
+    // 2. When several segments claim the same label, the largest one keeps it
+    for (int i = 0; i < pixels; ++i) {
+        if (roots[i] == i) owner[vote_label[i]] = -1;
+    }
+    for (int i = 0; i < pixels; ++i) {
+        if (roots[i] != i) continue;
+        int& current = owner[vote_label[i]];
+        if (current == -1 || sizes[i] > sizes[current] || (sizes[i] == sizes[current] && i < current)) {
+            current = i;
+        }
+    }
+
+    // 3. Winners inherit their label; the others get a label unused in this frame
+    for (int i = 0; i < pixels; ++i) {
+        if (roots[i] == i && owner[vote_label[i]] == i) used_stamp[vote_label[i]] = frame;
+    }
+    for (int i = 0; i < pixels; ++i) {
+        if (roots[i] != i || owner[vote_label[i]] == i) continue;
+        while (used_stamp[fresh_cursor] == frame) fresh_cursor = (fresh_cursor + 1) % pixels;
+        vote_label[i] = fresh_cursor;
+        used_stamp[fresh_cursor] = frame;
+    }
+
+    // 4. Write the final labels
+    for (int i = 0; i < pixels; ++i) {
+        labels[i] = vote_label[roots[i]];
+    }
+}
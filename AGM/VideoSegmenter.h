@@ -0,0 +1,60 @@
+#ifndef VIDEO_SEGMENTER_H
+#define VIDEO_SEGMENTER_H
+
+#include <vector>
+#include "Image.h"
+#include "SegmentationWorkspace.h"
+
+// Per-frame summary reported by VideoSegmenter.
+struct VideoFrameInfo {
+    int index = -1;               // Frame number, from 0
+    bool incremental_sort = false; // True if the previous frame's edge order was reused
+    double dropped_fraction = 1.0; // Fraction of edges that were out of order (1 on a cold start)
+    int segments = 0;
+    double milliseconds = 0.0;     // Blur + segmentation wall time
+};
+
+// Felzenszwalb segmentation of a frame sequence. Keeps one workspace across frames and
+// starts each frame from the previous frame's sorted edge order with updated weights,
+// which is nearly sorted when consecutive frames differ little. Optionally carries labels
+// forward: every segment takes the label most of its pixels had in the previous frame (a plurality,
+// not necessarily a majority); when several segments pick the same label, the largest keeps it.
+class VideoSegmenter {
+public:
+    VideoSegmenter(double k, float sigma, bool temporal_labels = true, bool deterministic = false);
+
+    // Blurs 'frame' in place and segments it. Returns the label map (valid until the next call).
+    // A frame of a different size than the previous one is a cold start.
+    const std::vector<int>& segmentFrame(Image& frame);
+
+    const VideoFrameInfo& lastFrame() const { return info; }
+
+    // Above this fraction of out-of-order edges the frame falls back to a full sort.
+    double max_dropped_fraction = 0.1;
+
+private:
+    double k;
+    float sigma;
+    bool temporal_labels;
+    bool deterministic; // Segmenter's deterministic mode
+    int width = 0, height = 0;
+    VideoFrameInfo info;
+    SegmentationWorkspace workspace;
+
+    // Temporal label state, all sized to the pixel count and reused across frames
+    std::vector<int> labels;          // Output labels of the current frame
+    std::vector<int> previous_labels; // Output labels of the previous frame
+    std::vector<int> vote_label;      // Most frequent previous label per segment root
+    std::vector<int> segment_size;    // Pixel count per segment root
+    std::vector<int> segment_end;     // End of each root's run in segment_pixels
+    std::vector<int> segment_pixels;  // Pixels grouped by segment
+    std::vector<int> label_count;     // Votes per previous label, zero between segments
+    std::vector<int> owner;           // Root that inherits each previous label
+    std::vector<int> used_stamp;      // Frame index at which a label was last assigned
+    int fresh_cursor = 0;             // Scan position for unused labels
+
+    // Maps the roots in workspace.labels to labels carried over from the previous frame.
+    void carryLabelsForward();
+};
+
+#endif // VIDEO_SEGMENTER_H
@@ -0,0 +1,134 @@
+#include "VideoSource.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include "stb_image.h"
+
+std::unique_ptr<VideoSource> VideoSource::open(const std::string& path) {
+    if (path.size() > 4 && path.compare(path.size() - 4, 4, ".y4m") == 0) {
+        FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file) {
+            std::cerr << "Error: Could not open video " << path << std::endl;
+            return nullptr;
+        }
+        std::unique_ptr<Y4mSource> source(new Y4mSource(file));
+        if (!source->valid()) {
+            std::cerr << "Error: " << path << " is not a supported YUV4MPEG2 file" << std::endl;
+            return nullptr;
+        }
+        return source;
+    }
+
+    // Image sequence: start at 0, or at 1 if there is no frame 0
+    for (int first_index : {0, 1}) {
+        FILE* probe = std::fopen(ImageSequenceSource::framePath(path, first_index).c_str(), "rb");
+        if (probe) {
+            std::fclose(probe);
+            return std::unique_ptr<VideoSource>(new ImageSequenceSource(path, first_index));
+        }
+    }
+    std::cerr << "Error: No frames found for " << path << std::endl;
+    return nullptr;
+}
+
+// ---- Y4M ----
+
+Y4mSource::Y4mSource(FILE* source_file) : file(source_file) {
+    char line[512];
+    if (!std::fgets(line, sizeof(line), file) || std::strncmp(line, "YUV4MPEG2 ", 10) != 0) {
+        width = height = 0;
+        return;
+    }
+
+    // Space separated header parameters: W<width> H<height> C<colourspace> ...
+    for (char* token = std::strtok(line + 10, " \n"); token; token = std::strtok(nullptr, " \n")) {
+        if (token[0] == 'W') width = std::atoi(token + 1);
+        else if (token[0] == 'H') height = std::atoi(token + 1);
+        else if (token[0] == 'C') {
+            std::string colourspace = token + 1;
+            if (colourspace == "420" || colourspace == "420jpeg" || colourspace == "420paldv" || colourspace == "420mpeg2") {
+                chroma_shift_x = 1; chroma_shift_y = 1;
+            }
+            else if (colourspace == "422") { chroma_shift_x = 1; chroma_shift_y = 0; }
+            else if (colourspace == "444") { chroma_shift_x = 0; chroma_shift_y = 0; }
+            else if (colourspace == "mono") { mono = true; }
+            else { // High bit depth (C420p10, ...) and alpha variants are not supported
+                std::cerr << "Error: Unsupported Y4M colourspace C" << colourspace << " (8-bit 420, 422, 444 or mono only)" << std::endl;
+                width = height = 0;
+                return;
+            }
+        }
+    }
+}
+
+Y4mSource::~Y4mSource() {
+    if (file) std::fclose(file);
+}
+
+bool Y4mSource::nextFrame(Image& frame) {
+    char line[256];
+    if (!std::fgets(line, sizeof(line), file) || std::strncmp(line, "FRAME", 5) != 0) {
+        return false;
+    }
+
+    int chroma_width = (width + (1 << chroma_shift_x) - 1) >> chroma_shift_x;
+    int chroma_height = (height + (1 << chroma_shift_y) - 1) >> chroma_shift_y;
+    size_t luma_size = static_cast<size_t>(width) * height;
+    size_t chroma_size = mono ? 0 : static_cast<size_t>(chroma_width) * chroma_height;
+    planes.resize(luma_size + 2 * chroma_size);
+    if (std::fread(planes.data(), 1, planes.size(), file) != planes.size()) {
+        return false;
+    }
+
+    frame.width = width;
+    frame.height = height;
+    frame.pixel_data.resize(luma_size);
+    const unsigned char* y_plane = planes.data();
+    const unsigned char* u_plane = y_plane + luma_size;
+    const unsigned char* v_plane = u_plane + chroma_size;
+    for (int r = 0; r < height; ++r) {
+        for (int c = 0; c < width; ++c) {
+            float y = y_plane[static_cast<size_t>(r) * width + c];
+            float u = 0.0f, v = 0.0f;
+            if (!mono) {
+                size_t chroma_idx = static_cast<size_t>(r >> chroma_shift_y) * chroma_width + (c >> chroma_shift_x);
+                u = u_plane[chroma_idx] - 128.0f;
+                v = v_plane[chroma_idx] - 128.0f;
+            }
+            Pixel& p = frame.pixel_data[frame.index(r, c)];
+            p.r = static_cast<unsigned char>(std::clamp(y + 1.402f * v, 0.0f, 255.0f));
+            p.g = static_cast<unsigned char>(std::clamp(y - 0.344136f * u - 0.714136f * v, 0.0f, 255.0f));
+            p.b = static_cast<unsigned char>(std::clamp(y + 1.772f * u, 0.0f, 255.0f));
+        }
+    }
+    return true;
+}
+
+// ---- Image sequence ----
+
+ImageSequenceSource::ImageSequenceSource(const std::string& frame_pattern, int first_index)
+    : pattern(frame_pattern), next_index(first_index) {}
+
+std::string ImageSequenceSource::framePath(const std::string& pattern, int index) {
+    std::vector<char> path(pattern.size() + 32);
+    std::snprintf(path.data(), path.size(), pattern.c_str(), index);
+    return path.data();
+}
+
+bool ImageSequenceSource::nextFrame(Image& frame) {
+    int width, height, channels;
+    unsigned char* data = stbi_load(framePath(pattern, next_index).c_str(), &width, &height, &channels, STBI_rgb);
+    if (!data) {
+        return false;
+    }
+    next_index++;
+
+    frame.width = width;
+    frame.height = height;
+    frame.pixel_data.resize(static_cast<size_t>(width) * height);
+    for (int i = 0; i < width * height; ++i) {
+        frame.pixel_data[i] = {data[3 * i + 0], data[3 * i + 1], data[3 * i + 2]};
+    }
+    stbi_image_free(data);
+    return true;
+}
@@ -0,0 +1,55 @@
+#ifndef VIDEO_SOURCE_H
+#define VIDEO_SOURCE_H
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Image.h"
+
+// Sequential source of RGB frames.
+class VideoSource {
+public:
+    virtual ~VideoSource() = default;
+
+    // Reads the next frame into 'frame' (resized as needed). Returns false at the end of the input.
+    virtual bool nextFrame(Image& frame) = 0;
+
+    // Opens 'path': a .y4m file, or a printf-style image sequence pattern such as "frames/%04d.png"
+    // (numbered from 0 or 1). Returns nullptr if it cannot be opened.
+    static std::unique_ptr<VideoSource> open(const std::string& path);
+};
+
+// YUV4MPEG2 reader (C420*, C422, C444 and mono, 8-bit), converted to RGB with BT.601 full-range coefficients.
+class Y4mSource : public VideoSource {
+public:
+    explicit Y4mSource(FILE* file);
+    ~Y4mSource() override;
+
+    bool valid() const { return width > 0 && height > 0; }
+    bool nextFrame(Image& frame) override;
+
+private:
+    FILE* file;
+    int width = 0, height = 0;
+    int chroma_shift_x = 1, chroma_shift_y = 1; // log2 of the chroma subsampling
+    bool mono = false;
+    std::vector<unsigned char> planes; // Y, U and V of the current frame
+};
+
+// Numbered image files loaded with stb_image.
+class ImageSequenceSource : public VideoSource {
+public:
+    ImageSequenceSource(const std::string& pattern, int first_index);
+
+    bool nextFrame(Image& frame) override;
+
+    // Formats 'pattern' with 'index'.
+    static std::string framePath(const std::string& pattern, int index);
+
+private:
+    std::string pattern;
+    int next_index;
+};
+
+#endif // VIDEO_SOURCE_H
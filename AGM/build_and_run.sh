@@ -1,2 +1,2 @@
-g++ -std=c++17 -Wall -o image_segmenter main.cpp Disjoint.cpp Segmenter.cpp GaussianBlur.cpp -I. -lpng -lm 
+g++ -std=c++17 -Wall -pthread -o image_segmenter main.cpp Disjoint.cpp Segmenter.cpp GaussianBlur.cpp LabelExport.cpp SegmentStats.cpp RegionAdjacency.cpp Instrumentation.cpp VideoSegmenter.cpp VideoSource.cpp PyramidSegmenter.cpp ShardCoordinator.cpp MemoryBudget.cpp -I. -lpng -lm 
 ./image_segmenter 
\ No newline at end of file
@@ -0,0 +1,3 @@
+# Build with the stage timers and counters (Instrumentation.h) compiled in, then print them
+g++ -std=c++17 -Wall -pthread -o image_segmenter_stats main.cpp Disjoint.cpp Segmenter.cpp GaussianBlur.cpp LabelExport.cpp SegmentStats.cpp RegionAdjacency.cpp Instrumentation.cpp VideoSegmenter.cpp VideoSource.cpp PyramidSegmenter.cpp ShardCoordinator.cpp MemoryBudget.cpp -DAGM_ENABLE_STATS -I. -lpng -lm 
+./image_segmenter_stats --stats 
\ No newline at end of file
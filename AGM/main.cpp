@@ -2,8 +2,18 @@
 #include <vector>
 #include <string>
 #include <fstream>
+#include <cstdio>
+#include <chrono>
 #include "Segmenter.h"
 #include "GaussianBlur.h"
+#include "LabelExport.h"
+#include "RegionAdjacency.h"
+#include "Instrumentation.h"
+#include "VideoSegmenter.h"
+#include "VideoSource.h"
+#include "PyramidSegmenter.h"
+#include "ShardCoordinator.h"
+#include "MemoryBudget.h"
 
 
 // --- STB_IMAGE INTEGRATION ---
@@ -18,6 +28,7 @@
 
 // Modified function to load an image using stb_image
 Image loadImageFromFile(const std::string& filename) {
+    AGM_STATS_TIMER(load_ms);
     int width, height, channels;
     unsigned char* img_data = stbi_load(filename.c_str(), &width, &height, &channels, STBI_rgb); // Force 3 channels (RGB)
 
@@ -40,6 +51,7 @@ Image loadImageFromFile(const std::string& filename) {
 
 // Function to save an image using stb_image (e.g., as PNG)
 bool saveImageToFile(const Image& img, const std::string& filename) {
+    AGM_STATS_TIMER(save_ms);
     std::vector<unsigned char> output_data(img.width * img.height * 3);
     for (int i = 0; i < img.width * img.height; ++i) {
         output_data[i * 3 + 0] = img.pixel_data[i].r;
@@ -57,29 +69,184 @@ bool saveImageToFile(const Image& img, const std::string& filename) {
     }
 }
 
+// Segments every frame of a .y4m file or image sequence, reusing state between frames.
+// Writes one label map per frame to '<output_prefix><frame>.npy' when a prefix is given.
+int runVideo(const std::string& input, const std::string& output_prefix, double k, float sigma, bool deterministic) {
+    std::unique_ptr<VideoSource> source = VideoSource::open(input);
+    if (!source) {
+        return 1;
+    }
+
+    VideoSegmenter video_segmenter(k, sigma, true, deterministic);
+    Image frame(0, 0);
+    double total_ms = 0.0;
+    int frames = 0;
+    while (source->nextFrame(frame)) {
+        const std::vector<int>& labels = video_segmenter.segmentFrame(frame);
+        const VideoFrameInfo& info = video_segmenter.lastFrame();
+        total_ms += info.milliseconds;
+        frames++;
+        std::cout << "Frame " << info.index << ": " << info.segments << " segments, " << info.milliseconds << " ms, "
+                  << (info.incremental_sort ? "incremental" : "full") << " sort (" << 100.0 * info.dropped_fraction
+                  << "% edges out of order)" << std::endl;
+
+        if (!output_prefix.empty()) {
+            AGM_STATS_TIMER(save_ms);
+            LabelExport::writeNpy(labels, frame.width, frame.height, ImageSequenceSource::framePath(output_prefix + "%04d.npy", info.index));
+        }
+    }
+
+    if (frames > 0) {
+        std::cout << frames << " frames, " << frames * 1000.0 / total_ms << " fps (segmentation only)" << std::endl;
+    }
+    return 0;
+}
+
+// Segments one image within 'limit_bytes': the strategy is picked from the up-front estimate
+// (MemoryBudget::plan) and the actual peak is reported afterwards.
+int runBudgeted(const std::string& input, size_t limit_bytes, double k, float sigma, bool deterministic) {
+    int width, height, channels;
+    if (!stbi_info(input.c_str(), &width, &height, &channels)) {
+        std::cerr << "Error: Could not read the size of " << input << std::endl;
+        return 1;
+    }
+    MemoryPlan plan = MemoryBudget::plan(width, height, limit_bytes);
+    const double mb = 1024.0 * 1024.0;
+    if (plan.strategy == MemoryStrategy::Refuse) {
+        std::cerr << "Error: " << input << " (" << width << "x" << height << ") needs at least "
+                  << plan.estimated_bytes / mb << " MB, above the " << limit_bytes / mb << " MB limit" << std::endl;
+        return 1;
+    }
+    std::cout << "Memory plan for " << width << "x" << height << ": " << MemoryBudget::name(plan.strategy);
+    if (plan.strategy == MemoryStrategy::Strips) std::cout << " (" << plan.tile_size << "px tiles)";
+    std::cout << ", estimated peak " << plan.estimated_bytes / mb << " MB (full pipeline " << plan.full_bytes / mb
+              << " MB, limit " << limit_bytes / mb << " MB)" << std::endl;
+
+    Image image = loadImageFromFile(input);
+    if (image.width == 0 || image.height == 0) {
+        return 1;
+    }
+
+    std::vector<int> labels;
+    {
+        BlurWorkspace blur; // Released before segmentation
+        if (plan.strategy == MemoryStrategy::Full) {
+            GaussianBlur::applyGaussianBlurToImage(image, sigma, blur);
+        } else {
+            GaussianBlur::applyGaussianBlurInStrips(image, sigma, 64, blur);
+        }
+    }
+    Segmenter segmenter(image, deterministic);
+    if (plan.strategy == MemoryStrategy::Full) {
+        labels = segmenter.segment(k);
+    } else if (plan.strategy == MemoryStrategy::CompactEdges) {
+        labels = segmenter.segmentCompact(k);
+    } else {
+        LocalTransport transport;
+        transport.deterministic = deterministic;
+        if (!ShardCoordinator::segment(image, k, plan.tile_size, transport, labels)) {
+            return 1;
+        }
+    }
+
+    LabelExport::writeNpy(labels, image.width, image.height, "segmentation_labels.npy");
+    saveImageToFile(segmenter.segmentationVisualization(labels), "segmentation_output.png");
+    std::cout << "Actual peak " << MemoryBudget::peakResidentBytes() / mb << " MB" << std::endl;
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
+    // Command line: --input picks the image (default "n sei.png"),
+    // --stats prints stage timers and algorithm counters at the end,
+    // --video segments a frame sequence instead of the sample images,
+    // --pyramid also runs the coarse-to-fine mode and compares it with the full-resolution result,
+    // --shards does the same for tiled segmentation in worker processes (--shards 0: in-process stand-in),
+    // --edit x,y,w,h inverts that rectangle afterwards and re-segments it with resegmentRect, compared with a full run,
+    // --deterministic orders equal-weight edges by index (results independent of sort implementation),
+    // --mem-limit segments the input image within a memory budget (e.g. 512M) with the cheapest strategy
+    // that fits, or refuses to run if none does
+    bool print_stats = false;
+    bool deterministic = false;
+    int pyramid_factor = 0;
+    int shard_workers = -1, tile_size = 256;
+    size_t mem_limit = 0;
+    Rect edit{0, 0, 0, 0};
+    std::string input_path = "n sei.png";
+    std::string video_input, video_output;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--input" && i + 1 < argc) {
+            input_path = argv[++i];
+        } else if (arg == "--stats") {
+            print_stats = true;
+        } else if (arg == "--deterministic") {
+            deterministic = true;
+        } else if (arg == "--video" && i + 1 < argc) {
+            video_input = argv[++i];
+        } else if (arg == "--video-out" && i + 1 < argc) {
+            video_output = argv[++i];
+        } else if (arg == "--pyramid" && i + 1 < argc) {
+            pyramid_factor = std::atoi(argv[++i]);
+        } else if (arg == "--mem-limit" && i + 1 < argc) {
+            mem_limit = MemoryBudget::parseSize(argv[++i]);
+            if (mem_limit == 0) {
+                std::cerr << "Invalid --mem-limit size '" << argv[i] << "', expected a byte count or e.g. 800k, 512M, 2G" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--edit" && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%d,%d,%d,%d", &edit.x, &edit.y, &edit.width, &edit.height) != 4 || edit.empty()) {
+                std::cerr << "Invalid --edit rectangle '" << argv[i] << "', expected x,y,width,height" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--shards" && i + 1 < argc) {
+            shard_workers = std::atoi(argv[++i]);
+        } else if (arg == "--tile" && i + 1 < argc) {
+            tile_size = std::max(16, std::atoi(argv[++i]));
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--input <image>] [--stats] [--deterministic] [--mem-limit <size>] [--edit <x,y,w,h>] [--pyramid <2|4>] [--shards <workers> [--tile <size>]] [--video <file.y4m|pattern%04d.png> [--video-out <prefix>]]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (!video_input.empty()) {
+        int status = runVideo(video_input, video_output, 500.0, 0.8f, deterministic);
+        if (print_stats) {
+            Instrumentation::report(std::cout);
+        }
+        return status;
+    }
+
+    if (mem_limit > 0) {
+        int status = runBudgeted(input_path, mem_limit, 500.0, 0.8f, deterministic);
+        if (print_stats) {
+            Instrumentation::report(std::cout);
+        }
+        return status;
+    }
+
     // 1. Load the input image
-    std::string input_image_path = "n sei.png";
+    std::string input_image_path = input_path;
     Image input_image = loadImageFromFile(input_image_path);
     if (input_image.width == 0 || input_image.height == 0) {
         return 1; // Exit if image couldn't be loaded
     }
 
-    input_image_path = "n sei.png";
     Image input_image_g = loadImageFromFile(input_image_path);//loads greyscale image
     if (input_image.width == 0 || input_image.height == 0) {
         return 1; // Exit if image couldn't be loaded
     }
 
     // 2. Applies gaussian blur
-    GaussianBlur::applyGaussianBlurToImage(input_image, 0.8f);
-    GaussianBlur::applyGaussianBlurToImage(input_image_g, 0.8f);
+    SegmentationWorkspace workspace; // scratch buffers shared by both images
+    GaussianBlur::applyGaussianBlurToImage(input_image, 0.8f, workspace.blur);
+    GaussianBlur::applyGaussianBlurToImage(input_image_g, 0.8f, workspace.blur);
 
     // 3. Runs Felzenszwalb segmentation algorithm
     double k = 500.0; // controls segment size, higher->less segments
-    Segmenter segmenter(input_image);
-    std::vector<int> labels = segmenter.segment(k);
-    Segmenter segmenter_g(input_image_g);
+    Segmenter segmenter(input_image, deterministic);
+    std::vector<SegmentStats> segment_stats;
+    std::vector<int> labels = segmenter.segment(k, &segment_stats);
+    Segmenter segmenter_g(input_image_g, deterministic);
     std::vector<int> labels_g = segmenter_g.segment(k);
 
     // 4. Saves image
@@ -88,5 +255,95 @@ int main(int argc, char* argv[]) {
     Image segmentation_output_g = segmenter_g.segmentationVisualization(labels_g);
     saveImageToFile(segmentation_output_g, "segmentation_output_g.png");
 
+    // 5. Saves the raw label maps (no colour step), statistics and adjacency graph
+    RegionAdjacencyGraph adjacency = RegionAdjacency::build(labels, input_image);
+    {
+        AGM_STATS_TIMER(save_ms);
+        LabelExport::writeNpy(labels, input_image.width, input_image.height, "segmentation_labels.npy");
+        LabelExport::writeRLE(labels, input_image.width, input_image.height, "segmentation_labels.rle");
+        SegmentStatistics::writeCSV(segment_stats, "segmentation_stats.csv");
+        RegionAdjacency::writeCSV(adjacency, "segmentation_adjacency.csv");
+        LabelExport::writeNpy(labels_g, input_image_g.width, input_image_g.height, "segmentation_labels_g.npy", LabelExport::DType::UInt16);
+    }
+
+    // 6. Optional coarse-to-fine run, reported against the full-resolution labels
+    if (pyramid_factor > 1) {
+        auto start = std::chrono::steady_clock::now();
+        segmenter.segment(k, workspace);
+        double full_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        PyramidReport report;
+        std::vector<int> pyramid_labels = PyramidSegmenter::segment(input_image, k, pyramid_factor, 2 * pyramid_factor, &report, deterministic);
+        SegmentationQuality quality = PyramidSegmenter::compare(pyramid_labels, labels, input_image.width, input_image.height);
+        saveImageToFile(segmenter.segmentationVisualization(pyramid_labels), "segmentation_output_pyramid.png");
+
+        std::cout << "Pyramid 1/" << pyramid_factor * pyramid_factor << ": " << report.coarse_ms + report.refine_ms
+                  << " ms (coarse " << report.coarse_ms << " ms, refine " << report.refine_ms << " ms, "
+                  << report.band_pixels << " band pixels) vs full resolution " << full_ms << " ms" << std::endl;
+        std::cout << "  segments " << quality.segments << " (coarse " << report.coarse_segments << ", full "
+                  << quality.reference_segments << "), ASA " << quality.achievable_accuracy
+                  << ", boundary recall " << quality.boundary_recall << ", precision " << quality.boundary_precision << std::endl;
+    }
+
+    // 7. Optional tiled run in worker processes, stitched and compared with the full-resolution labels
+    if (shard_workers >= 0) {
+        LocalTransport local;
+        ProcessTransport processes(shard_workers);
+        ShardTransport& transport = shard_workers == 0 ? static_cast<ShardTransport&>(local) : processes;
+        transport.deterministic = deterministic;
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<int> shard_labels;
+        if (!ShardCoordinator::segment(input_image, k, tile_size, transport, shard_labels)) {
+            return 1;
+        }
+        double shard_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        SegmentationQuality quality = PyramidSegmenter::compare(shard_labels, labels, input_image.width, input_image.height);
+        saveImageToFile(segmenter.segmentationVisualization(shard_labels), "segmentation_output_shards.png");
+
+        std::cout << "Shards (" << tile_size << "px tiles, " << (shard_workers == 0 ? std::string("in-process") : std::to_string(shard_workers) + " workers")
+                  << "): " << shard_ms << " ms, segments " << quality.segments << " (full " << quality.reference_segments
+                  << "), ASA " << quality.achievable_accuracy << ", boundary recall " << quality.boundary_recall << std::endl;
+    }
+
+    // 8. Optional local edit: the rectangle is inverted in the source, re-blurred and re-segmented in
+    // place, then compared with a full segmentation of the edited image
+    edit = edit.expandedWithin(0, input_image.width, input_image.height);
+    if (!edit.empty()) {
+        Image source = loadImageFromFile(input_image_path);
+        Image edited = input_image;
+        Segmenter edit_segmenter(edited, deterministic);
+        SegmentationWorkspace edit_workspace;
+        edit_workspace.keep_segment_sizes = true;
+        std::vector<int> edit_labels = edit_segmenter.segment(k, edit_workspace);
+        for (int r = edit.y; r < edit.y + edit.height; ++r) {
+            for (int c = edit.x; c < edit.x + edit.width; ++c) {
+                Pixel& p = source.pixel_data[source.index(r, c)];
+                p = {static_cast<unsigned char>(255 - p.r), static_cast<unsigned char>(255 - p.g), static_cast<unsigned char>(255 - p.b)};
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        int radius = GaussianBlur::KernelRadius(0.8f);
+        GaussianBlur::blurRegion(source, edited, edit.expandedWithin(radius, edited.width, edited.height), 0.8f, edit_workspace.blur);
+        int relabelled = edit_segmenter.resegmentRect(k, edit_labels, edit, radius, edit_workspace);
+        double edit_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        std::vector<int> full_labels = edit_segmenter.segment(k);
+        double full_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        SegmentationQuality quality = PyramidSegmenter::compare(edit_labels, full_labels, edited.width, edited.height);
+        saveImageToFile(edit_segmenter.segmentationVisualization(edit_labels), "segmentation_output_edit.png");
+
+        std::cout << "Edit " << edit.width << "x" << edit.height << ": " << edit_ms << " ms (" << relabelled
+                  << " pixels relabelled) vs full run " << full_ms << " ms, segments " << quality.segments << " (full "
+                  << quality.reference_segments << "), ASA " << quality.achievable_accuracy << ", boundary recall "
+                  << quality.boundary_recall << ", precision " << quality.boundary_precision << std::endl;
+    }
+
+    if (print_stats) {
+        Instrumentation::report(std::cout);
+    }
+
     return 0;
 }
\ No newline at end of file
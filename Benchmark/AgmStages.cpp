@@ -0,0 +1,110 @@
+#include "Benchmark.h"
+#include "../AGM/GaussianBlur.h"
+#include "../AGM/Parallel.h"
+#include "../AGM/RegionAdjacency.h"
+#include "../AGM/Segmenter.h"
+#include <algorithm>
+#include <random>
+
+void benchmarkAgm(const std::vector<uint8_t>& rgb, int width, int height, int threads,
+                  const BenchmarkConfig& config, std::vector<StageResult>& results) {
+    Parallel::setThreadCount(threads);
+
+    Image source(width, height);
+    for (int i = 0; i < width * height; ++i) {
+        source.pixel_data[i] = {rgb[3 * i + 0], rgb[3 * i + 1], rgb[3 * i + 2]};
+    }
+    auto record = [&](const char* stage, std::vector<double> samples) {
+        results.push_back({"agm", stage, width, height, threads, std::move(samples)});
+    };
+
+    // Gaussian blur (on a fresh copy each run)
+    Image blurred = source;
+    record("gaussian_blur", measure(config.repeat,
+        [&] { blurred = source; },
+        [&] { GaussianBlur::applyGaussianBlurToImage(blurred, config.sigma); }));
+
+    Segmenter segmenter(blurred);
+
+    // Graph construction
+    std::vector<Edge> edges;
+    record("create_graph", measure(config.repeat,
+        [&] { edges.clear(); edges.shrink_to_fit(); },
+        [&] { edges = segmenter.createGraph(); }));
+
+    // Edge sort (on an unsorted copy each run)
+    std::vector<Edge> unsorted = edges;
+    record("sort_edges", measure(config.repeat,
+        [&] { edges = unsorted; },
+        [&] { segmenter.sortEdges(edges); }));
+    std::vector<Edge>().swap(unsorted);
+
+    // Disjoint merge loop (fresh disjoint sets each run)
+    Disjoint disjoint_sets(0);
+    record("merge_components", measure(config.repeat,
+        [&] { disjoint_sets = Disjoint(width * height); },
+        [&] { Segmenter::mergeComponents(edges, config.k, disjoint_sets); }));
+    std::vector<Edge>().swap(edges);
+
+    // Visualization of the final labels
+    std::vector<int> labels(width * height);
+    for (int i = 0; i < width * height; ++i) labels[i] = disjoint_sets.find_set_root(i);
+    record("segmentation_visualization", measure(config.repeat,
+        [] {},
+        [&] { Image output = segmenter.segmentationVisualization(labels); }));
+
+    // Local re-segmentation of a 64x64 rectangle in the middle (labels and saved segment sizes restored each run)
+    SegmentationWorkspace workspace;
+    workspace.keep_segment_sizes = true;
+    segmenter.segment(config.k, workspace);
+    std::vector<int> saved_size = workspace.segment_size;
+    std::vector<double> saved_internal = workspace.segment_internal;
+    Rect dirty = Rect{width / 2 - 32, height / 2 - 32, 64, 64}.expandedWithin(0, width, height);
+    record("resegment_rect", measure(config.repeat,
+        [&] {
+            labels = workspace.labels;
+            workspace.segment_size = saved_size;
+            workspace.segment_internal = saved_internal;
+        },
+        [&] { segmenter.resegmentRect(config.k, labels, dirty, GaussianBlur::KernelRadius(config.sigma), workspace); }));
+}
+
+uint64_t digestAgm(const std::vector<uint8_t>& rgb, int width, int height, int threads, const BenchmarkConfig& config) {
+    Parallel::setThreadCount(threads);
+
+    Image image(width, height);
+    for (int i = 0; i < width * height; ++i) {
+        image.pixel_data[i] = {rgb[3 * i + 0], rgb[3 * i + 1], rgb[3 * i + 2]};
+    }
+    GaussianBlur::applyGaussianBlurToImage(image, config.sigma);
+    // The edges are shuffled differently for every thread count: in deterministic mode the merge order,
+    // and so the digest, must not depend on the order they come in
+    Segmenter segmenter(image, true);
+    SegmentationWorkspace workspace;
+    segmenter.createGraph(workspace.edges);
+    std::shuffle(workspace.edges.begin(), workspace.edges.end(), std::mt19937(threads));
+    segmenter.sortEdges(workspace.edges);
+    std::vector<SegmentStats> stats;
+    std::vector<int> labels = segmenter.segmentSorted(config.k, workspace, &stats);
+    RegionAdjacencyGraph graph = RegionAdjacency::build(labels, image);
+
+    std::vector<uint8_t> blurred(width * height * 3);
+    for (int i = 0; i < width * height; ++i) {
+        blurred[3 * i + 0] = image.pixel_data[i].r;
+        blurred[3 * i + 1] = image.pixel_data[i].g;
+        blurred[3 * i + 2] = image.pixel_data[i].b;
+    }
+    uint64_t hash = hashVector(blurred, 14695981039346656037ull);
+    hash = hashVector(labels, hash);
+    for (const SegmentStats& s : stats) {
+        int ints[] = {s.label, s.area, s.min_x, s.min_y, s.max_x, s.max_y};
+        double doubles[] = {s.centroid_x, s.centroid_y, s.mean_r, s.mean_g, s.mean_b};
+        hash = hashBytes(ints, sizeof(ints), hash);
+        hash = hashBytes(doubles, sizeof(doubles), hash);
+    }
+    hash = hashVector(graph.region_label, hash);
+    hash = hashVector(graph.offsets, hash);
+    hash = hashVector(graph.neighbors, hash);
+    hash = hashVector(graph.boundary_length, hash);
+    return hashVector(graph.mean_weight, hash);
+}
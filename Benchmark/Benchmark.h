@@ -0,0 +1,88 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Timing samples of one stage, for one image size and thread count.
+struct StageResult {
+    std::string engine;  // "agm" or "dijkstra"
+    std::string stage;   // Stage name, e.g. "gaussian_blur"
+    int width;
+    int height;
+    int threads;
+    std::vector<double> samples_ms;
+};
+
+// Benchmark configuration shared by both engines.
+struct BenchmarkConfig {
+    int repeat = 3;       // Timed runs per stage
+    double k = 500.0;     // Felzenszwalb scale parameter
+    float sigma = 0.8f;   // Gaussian blur sigma
+    int seed_grid = 4;    // Dijkstra seeds: seed_grid x seed_grid regular grid
+};
+
+// Deterministic synthetic RGB test image (interleaved, width * height * 3 bytes):
+// smooth colour gradients split into random rectangular regions, plus noise. 'seed' picks the variant.
+std::vector<uint8_t> makeSyntheticImage(int width, int height, uint32_t seed = 12345u);
+
+// FNV-1a hash of 'size' bytes, continuing from 'hash'.
+inline uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// Hash of a vector of plain values, length included.
+template <typename T>
+uint64_t hashVector(const std::vector<T>& values, uint64_t hash) {
+    uint64_t count = values.size();
+    hash = hashBytes(&count, sizeof(count), hash);
+    return hashBytes(values.data(), values.size() * sizeof(T), hash);
+}
+
+// Runs 'setup' untimed, then times 'run', 'repeat' times. Returns the samples in milliseconds.
+template <typename Setup, typename Run>
+std::vector<double> measure(int repeat, Setup setup, Run run) {
+    std::vector<double> samples;
+    for (int i = 0; i < repeat; ++i) {
+        setup();
+        auto start = std::chrono::steady_clock::now();
+        run();
+        auto end = std::chrono::steady_clock::now();
+        samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return samples;
+}
+
+// Stage drivers, one per engine (separate translation units: both engines define an 'Image' type).
+void benchmarkAgm(const std::vector<uint8_t>& rgb, int width, int height, int threads,
+                  const BenchmarkConfig& config, std::vector<StageResult>& results);
+void benchmarkDijkstra(const std::vector<uint8_t>& rgb, int width, int height, int threads,
+                       const BenchmarkConfig& config, std::vector<StageResult>& results);
+
+// Digest of everything one engine produces for 'rgb' with 'threads' workers: labels, per-segment
+// statistics and region adjacency graph (AGM runs in Segmenter's deterministic mode, on edges shuffled
+// with 'threads' as seed). Equal digests across thread counts mean bit-identical outputs.
+uint64_t digestAgm(const std::vector<uint8_t>& rgb, int width, int height, int threads, const BenchmarkConfig& config);
+uint64_t digestDijkstra(const std::vector<uint8_t>& rgb, int width, int height, int threads, const BenchmarkConfig& config);
+
+// Applies a sequence of seed edits (a removal, an addition, a relabelled seed, several at once) with CM::updateSeeds,
+// for fsum and fmax, on the exact gradient cost and on the RGB distance with EdgeWeights::Uint8, and compares each
+// result with a fresh run() on the same seeds: costs must be identical and the repaired forest consistent (every
+// label follows the parent pointers to a seed of that label). Labels may differ on ties; those pixels are added to
+// 'tieLabels'. 'seed' picks the edits. Returns the number of failed updates.
+int checkDijkstraUpdates(const std::vector<uint8_t>& rgb, int width, int height, uint32_t seed, const BenchmarkConfig& config,
+                         long long& tieLabels);
+
+// Times the IFT of the Dijkstra engine on the image at 'path' with each priority queue: std::priority_queue
+// (lazy deletion), the indexed heap, the radix heap and, for integer costs, the bucket queue. Runs on the
+// gradient (integer costs) and on the RGB image (float costs). Returns false if the image cannot be loaded.
+bool compareDijkstraQueues(const std::string& path, const BenchmarkConfig& config, std::vector<StageResult>& results);
+
+#endif // BENCHMARK_H
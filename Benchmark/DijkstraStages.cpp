@@ -0,0 +1,300 @@
+#include "Benchmark.h"
+
+#include <cstring>
+#include <iostream>
+#include <queue>
+
+// The Dijkstra engine is a header-style unity build that defines its own 'Image'; rename it so it can
+// be linked next to AGM, and keep its copy of stb private to this translation unit.
+#define STB_IMAGE_STATIC
+#define STB_IMAGE_WRITE_STATIC
+#define Image DijkstraImage
+#include "../Dijkstra/src/dijkstra.cpp"
+#include "../Dijkstra/src/gradient.cpp"
+#include "../Dijkstra/src/regionalMinima.cpp"
+#undef Image
+
+void benchmarkDijkstra(const std::vector<uint8_t>& rgb, int width, int height, int threads,
+                       const BenchmarkConfig& config, std::vector<StageResult>& results) {
+    parallel::setThreadCount(threads);
+
+    ImageView source(rgb.data(), width, height, 3);
+    auto record = [&](const char* stage, std::vector<double> samples) {
+        results.push_back({"dijkstra", stage, width, height, threads, std::move(samples)});
+    };
+
+    // Sobel gradient (the previous result is released before each run)
+    DijkstraImage gradientImage;
+    record("generate_gradient", measure(config.repeat,
+        [&] { gradientImage = DijkstraImage(); },
+        [&] { gradientImage = gradient::generateGradient(source); }));
+
+    // Seeded IFT on the gradient image (8-connectivity, Euclidean edge cost)
+    std::map<int, int> seeds;
+    int label = 1;
+    for (int gy = 0; gy < config.seed_grid; ++gy) {
+        for (int gx = 0; gx < config.seed_grid; ++gx) {
+            int x = (2 * gx + 1) * width / (2 * config.seed_grid);
+            int y = (2 * gy + 1) * height / (2 * config.seed_grid);
+            seeds[y * width + x] = label++;
+        }
+    }
+    EuclidianDistance_EdgeCost edgeCost(gradientImage);
+    CM cm(gradientImage, seeds, true);
+    record("cm_run", measure(config.repeat,
+        [&] {
+            cm = CM(gradientImage, seeds, true);
+            cm.edgeCost = &edgeCost;
+        },
+        [&] { cm.run(); }));
+
+    // The same IFT with the edge weights precomputed into per-direction planes first (exact on the gradient)
+    record("cm_run_weight_planes", measure(config.repeat,
+        [&] {
+            cm = CM(gradientImage, seeds, true);
+            cm.edgeCost = &edgeCost;
+            cm.edgeWeights = EdgeWeights::Float;
+        },
+        [&] { cm.run(); }));
+
+    // Max-arc (fmax) path costs: at most 255 on the gradient, so the bucket queue has 256 buckets
+    record("cm_run_fmax", measure(config.repeat,
+        [&] {
+            cm = CM(gradientImage, seeds, true);
+            cm.edgeCost = &edgeCost;
+            cm.pathCost = PathCost::Max;
+        },
+        [&] { cm.run(); }));
+
+    // Differential IFT after a full run: one seed removed and one added, as in an interactive edit
+    std::map<int, int> edited = seeds;
+    edited.erase(edited.begin());
+    edited[height / 3 * width + width / 3] = label;
+    record("cm_update_seeds", measure(config.repeat,
+        [&] {
+            cm = CM(gradientImage, seeds, true);
+            cm.edgeCost = &edgeCost;
+            cm.run();
+        },
+        [&] { cm.updateSeeds(edited); }));
+
+    // Automatic seeds: h-minima of the gradient (depth 10), labeled in parallel
+    std::vector<int> markers;
+    record("regional_minima", measure(config.repeat,
+        [&] { markers.clear(); },
+        [&] { markers = regionalMinima::markers(gradientImage, 10, true); }));
+}
+
+// Baseline IFT on std::priority_queue with lazy deletion (no decrease-key), for the queue comparison.
+// Uses 8-connectivity, like every CM built by the benchmark, and the same static cost policy as CM::run.
+template <typename Cost>
+static void runPriorityQueue(CM& cm, const Cost& cost) {
+    const Neighborhood<true> neighborhood(cm.image.w);
+    typedef std::pair<float, int> Entry; // (cost, pixel)
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    while (!cm.queue.empty()) {
+        int seed = cm.queue.pop();
+        queue.push({cm.costs[seed], seed});
+    }
+    while (!queue.empty()) {
+        Entry top = queue.top();
+        queue.pop();
+        int current = top.second;
+        int index = maskIndex(current, cm.image.w);
+        if (cm.finalized.data[index]) continue;
+        cm.finalized.data[index] = 1;
+        neighborhood.forEachOpen(current, index, cm.finalized, [&](int neighbor, int direction, int) {
+            float newCost = top.first + cost(current, neighbor, direction);
+            if (newCost < cm.costs[neighbor]) {
+                cm.costs[neighbor] = newCost;
+                cm.labels[neighbor] = cm.labels[current];
+                cm.parent[neighbor] = current;
+                queue.push({newCost, neighbor});
+            }
+        });
+    }
+}
+
+bool compareDijkstraQueues(const std::string& path, const BenchmarkConfig& config, std::vector<StageResult>& results) {
+    DijkstraImage source(path.c_str());
+    if (!source.data) return false;
+    if (source.channels != 3) {
+        std::cerr << path << ": expected an RGB image" << std::endl;
+        return false;
+    }
+    DijkstraImage gradientImage(gradient::generateGradient(source));
+    int width = source.w, height = source.h;
+
+    std::map<int, int> seeds;
+    int label = 1;
+    for (int gy = 0; gy < config.seed_grid; ++gy) {
+        for (int gx = 0; gx < config.seed_grid; ++gx) {
+            seeds[(2 * gy + 1) * height / (2 * config.seed_grid) * width + (2 * gx + 1) * width / (2 * config.seed_grid)] = label++;
+        }
+    }
+
+    // Integer costs on the gradient (|a - b|) and float costs in RGB space (Euclidean distance)
+    for (int colour = 0; colour < 2; ++colour) {
+        const DijkstraImage& graphImage = colour ? source : gradientImage;
+        EuclidianDistance_EdgeCost edgeCost(graphImage);
+        std::vector<float> reference;
+        struct Variant { const char* stage; PathQueue queue; bool standard; };
+        const Variant variants[] = {
+            {"std_priority_queue", PathQueue::Heap, true},
+            {"indexed_heap", PathQueue::Heap, false},
+            {"radix_heap", PathQueue::Radix, false},
+            {"bucket_queue", PathQueue::Buckets, false},
+        };
+        for (const Variant& variant : variants) {
+            if (variant.queue == PathQueue::Buckets && edgeCost.maxIntegerCost() < 0) continue; // Would fall back to the heap
+            CM cm(graphImage, seeds, true);
+            std::vector<double> samples = measure(config.repeat,
+                [&] {
+                    cm = CM(graphImage, seeds, true);
+                    cm.edgeCost = &edgeCost;
+                    cm.pathQueue = variant.queue;
+                },
+                [&] {
+                    if (variant.standard) visitCostPolicy(cm.edgeCost, [&](const auto& cost) { runPriorityQueue(cm, cost); });
+                    else cm.run();
+                });
+
+            // Every queue must reach the same optimum costs
+            if (reference.empty()) reference = cm.costs;
+            else if (cm.costs != reference) std::cerr << path << ": " << variant.stage << " costs differ" << std::endl;
+            std::string stage = std::string(colour ? "rgb_" : "gradient_") + variant.stage;
+            results.push_back({"dijkstra", stage, width, height, 1, std::move(samples)});
+        }
+    }
+    return true;
+}
+
+// Pixels of 'cm' that break its forest: a root that is not a seed (or marker) of its own label at cost 0, or a
+// pixel without its parent's label or without the cost of its parent's path extended by the arc between them.
+template <typename Path, typename Cost>
+static int forestErrors(const CM& cm, const Cost& cost) {
+    int errors = 0;
+    for (int pos = 0; pos < static_cast<int>(cm.labels.size()); ++pos) {
+        int parent = cm.parent[pos];
+        if (parent < 0) {
+            auto seed = cm.seeds.find(pos);
+            int seedLabel = seed != cm.seeds.end() ? seed->second : cm.markers.empty() ? -1 : cm.markers[pos];
+            errors += seedLabel < 0 || cm.labels[pos] != seedLabel || cm.costs[pos] != 0.0f;
+        } else {
+            errors += cm.labels[pos] != cm.labels[parent] || cm.costs[pos] != Path::extend(cm.costs[parent], cost(parent, pos));
+        }
+    }
+    return errors;
+}
+
+int checkDijkstraUpdates(const std::vector<uint8_t>& rgb, int width, int height, uint32_t seed, const BenchmarkConfig& config,
+                         long long& tieLabels) {
+    ImageView source(rgb.data(), width, height, 3);
+    DijkstraImage gradientImage(gradient::generateGradient(source));
+    EuclidianDistance_EdgeCost gradientCost(gradientImage);
+    EuclidianDistance_EdgeCost colorCost(source); // Float weights, rounded by uint8 planes
+    uint32_t state = seed ? seed : 12345u;
+    auto next = [&state]() { // xorshift32
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    };
+
+    // Exact weights on the gradient, and uint8 planes on the RGB distance: the repaired area must use the same weights
+    struct Variant { EdgeCost* edgeCost; EdgeWeights edgeWeights; const char* name; };
+    const Variant variants[] = {{&gradientCost, EdgeWeights::OnTheFly, "gradient"}, {&colorCost, EdgeWeights::Uint8, "rgb uint8"}};
+
+    int failures = 0;
+    for (const Variant& variant : variants) {
+        for (PathCost pathCost : {PathCost::Sum, PathCost::Max}) {
+            std::map<int, int> seeds;
+            int label = 1;
+            for (int gy = 0; gy < config.seed_grid; ++gy) {
+                for (int gx = 0; gx < config.seed_grid; ++gx) {
+                    seeds[(2 * gy + 1) * height / (2 * config.seed_grid) * width + (2 * gx + 1) * width / (2 * config.seed_grid)] = label++;
+                }
+            }
+            CM cm(gradientImage, seeds, true);
+            cm.edgeCost = variant.edgeCost;
+            cm.edgeWeights = variant.edgeWeights;
+            cm.pathCost = pathCost;
+            cm.run();
+
+            for (int step = 0; step < 8; ++step) {
+                // Cycles through: one removal, one addition, one seed relabelled, half removed and three added
+                int edit = step % 4;
+                int removals = edit == 0 ? 1 : edit == 3 ? static_cast<int>(seeds.size()) / 2 : 0;
+                for (int i = 0; i < removals && seeds.size() > 1; ++i) {
+                    seeds.erase(std::next(seeds.begin(), next() % seeds.size()));
+                }
+                for (int i = 0; i < (edit == 1 ? 1 : edit == 3 ? 3 : 0); ++i) {
+                    seeds[next() % (width * height)] = label++;
+                }
+                if (edit == 2) {
+                    std::next(seeds.begin(), next() % seeds.size())->second = label++;
+                }
+
+                cm.updateSeeds(seeds);
+                CM fresh(gradientImage, seeds, true);
+                fresh.edgeCost = variant.edgeCost;
+                fresh.edgeWeights = variant.edgeWeights;
+                fresh.pathCost = pathCost;
+                fresh.run();
+
+                int costErrors = 0, treeErrors = 0;
+                for (size_t pos = 0; pos < cm.costs.size(); ++pos) {
+                    costErrors += cm.costs[pos] != fresh.costs[pos];
+                    tieLabels += cm.labels[pos] != fresh.labels[pos];
+                }
+                visitWeightPolicy(variant.edgeCost, variant.edgeWeights, [&](const auto& cost) {
+                    treeErrors = pathCost == PathCost::Max ? forestErrors<MaxPathCost>(cm, cost) : forestErrors<SumPathCost>(cm, cost);
+                });
+                if (costErrors || treeErrors) {
+                    failures++;
+                    std::cerr << "UPDATE MISMATCH " << width << "x" << height << " " << variant.name << " " << (pathCost == PathCost::Max ? "fmax" : "fsum")
+                              << " step " << step << ": " << costErrors << " costs differ from a full run, " << treeErrors
+                              << " pixels break the forest" << std::endl;
+                }
+            }
+        }
+    }
+    return failures;
+}
+
+uint64_t digestDijkstra(const std::vector<uint8_t>& rgb, int width, int height, int threads, const BenchmarkConfig& config) {
+    parallel::setThreadCount(threads);
+
+    ImageView source(rgb.data(), width, height, 3);
+    DijkstraImage gradientImage(gradient::generateGradient(source));
+
+    std::map<int, int> seeds;
+    int label = 1;
+    for (int gy = 0; gy < config.seed_grid; ++gy) {
+        for (int gx = 0; gx < config.seed_grid; ++gx) {
+            seeds[(2 * gy + 1) * height / (2 * config.seed_grid) * width + (2 * gx + 1) * width / (2 * config.seed_grid)] = label++;
+        }
+    }
+    EuclidianDistance_EdgeCost edgeCost(gradientImage);
+    CM cm(gradientImage, seeds, true);
+    cm.edgeCost = &edgeCost;
+    cm.run();
+    std::vector<SegmentStat> stats = cm.statistics(source);
+    RegionGraph graph = cm.adjacency();
+
+    uint64_t hash = hashBytes(gradientImage.data, gradientImage.size);
+    hash = hashVector(cm.labels, hash);
+    hash = hashVector(cm.costs, hash);
+    for (const SegmentStat& s : stats) {
+        int ints[] = {s.label, s.area, s.minX, s.minY, s.maxX, s.maxY};
+        double doubles[] = {s.centroidX, s.centroidY};
+        hash = hashBytes(ints, sizeof(ints), hash);
+        hash = hashBytes(doubles, sizeof(doubles), hash);
+        hash = hashVector(s.meanColor, hash);
+    }
+    hash = hashVector(graph.regionLabel, hash);
+    hash = hashVector(graph.offsets, hash);
+    hash = hashVector(graph.neighbors, hash);
+    hash = hashVector(graph.boundaryLength, hash);
+    return hashVector(graph.meanWeight, hash);
+}
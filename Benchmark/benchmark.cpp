@@ -0,0 +1,240 @@
+// Stage benchmark for both segmentation engines.
+// Times every hot stage across image sizes and thread counts and prints the results as JSON.
+//
+// Usage: benchmark [--sizes 0.25,1,4,16,100] [--threads 1,8] [--repeat 3] [--engine agm|dijkstra|all] [--output file.json]
+//        benchmark --check-determinism [--sizes 0.01,0.05,0.3] [--threads 1,2,3,4,8] [--inputs 8] [--engine ...]
+//        benchmark --check-updates [--sizes 0.01,0.05,0.3] [--inputs 8]
+//        benchmark --compare-queues image1.png,image2.png [--repeat 3] [--output file.json]
+//
+// --check-determinism runs each engine on 'inputs' synthetic images per size (every other one posterized,
+// for many equal edge weights) with every thread count and verifies that all outputs are bit-identical;
+// the exit status is non-zero if any differ.
+// --check-updates repeats seed edits with the differential IFT (CM::updateSeeds) and compares every result
+// with a full run, for fsum and fmax, with exact gradient weights and with uint8 planes over the RGB distance
+// (see checkDijkstraUpdates); the exit status is non-zero if any fails.
+// --compare-queues times the Dijkstra IFT with each priority queue on real images (see compareDijkstraQueues).
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include "Benchmark.h"
+
+std::vector<uint8_t> makeSyntheticImage(int width, int height, uint32_t seed) {
+    uint32_t state = seed ? seed : 12345u; // xorshift32 must not start at 0
+    auto next = [&state]() { // xorshift32, fixed seed for reproducible inputs
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    };
+
+    // Random rectangular regions, each with its own base colour, on a coarse 64-pixel grid
+    const int cell = 64;
+    int cells_x = (width + cell - 1) / cell;
+    int cells_y = (height + cell - 1) / cell;
+    std::vector<uint8_t> palette(static_cast<size_t>(cells_x) * cells_y * 3);
+    for (uint8_t& value : palette) value = static_cast<uint8_t>(next() % 256);
+
+    std::vector<uint8_t> rgb(static_cast<size_t>(width) * height * 3);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            // Merge neighbouring cells in pairs so regions are not all the same shape
+            int cx = (x / cell) & ~((y / cell) & 1);
+            int cy = (y / cell) & ~((x / cell) & 1);
+            const uint8_t* base = &palette[(static_cast<size_t>(cy) * cells_x + cx) * 3];
+            size_t idx = (static_cast<size_t>(y) * width + x) * 3;
+            for (int ch = 0; ch < 3; ++ch) {
+                int value = base[ch] + (x % cell) / 4 - (y % cell) / 4 + static_cast<int>(next() % 9) - 4;
+                rgb[idx + ch] = static_cast<uint8_t>(std::min(255, std::max(0, value)));
+            }
+        }
+    }
+    return rgb;
+}
+
+template <typename T>
+static std::vector<T> parseList(const std::string& text) {
+    std::vector<T> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        std::stringstream item_stream(item);
+        T value;
+        if (item_stream >> value) values.push_back(value);
+    }
+    return values;
+}
+
+static double median(std::vector<double> samples) {
+    std::sort(samples.begin(), samples.end());
+    size_t n = samples.size();
+    if (n == 0) return 0.0;
+    return n % 2 ? samples[n / 2] : 0.5 * (samples[n / 2 - 1] + samples[n / 2]);
+}
+
+static void writeJson(std::ostream& out, const BenchmarkConfig& config, const std::vector<StageResult>& results) {
+    out << "{\n";
+    out << "  \"benchmark\": \"image-segmentation-stages\",\n";
+    out << "  \"format_version\": 1,\n";
+    out << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+    out << "  \"repeat\": " << config.repeat << ",\n";
+    out << "  \"k\": " << config.k << ",\n";
+    out << "  \"sigma\": " << config.sigma << ",\n";
+    out << "  \"results\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const StageResult& r = results[i];
+        double megapixels = static_cast<double>(r.width) * r.height / 1e6;
+        out << (i ? ",\n" : "\n");
+        out << "    {\"engine\": \"" << r.engine << "\", \"stage\": \"" << r.stage << "\""
+            << ", \"width\": " << r.width << ", \"height\": " << r.height << ", \"megapixels\": " << megapixels
+            << ", \"threads\": " << r.threads
+            << ", \"median_ms\": " << median(r.samples_ms)
+            << ", \"min_ms\": " << *std::min_element(r.samples_ms.begin(), r.samples_ms.end())
+            << ", \"max_ms\": " << *std::max_element(r.samples_ms.begin(), r.samples_ms.end())
+            << ", \"mpix_per_s\": " << megapixels / (median(r.samples_ms) / 1000.0) << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+// 4:3 image size of about 'megapixels'.
+static void imageSize(double megapixels, int& width, int& height) {
+    width = std::max(1, static_cast<int>(std::lround(std::sqrt(megapixels * 1e6 * 4.0 / 3.0))));
+    height = std::max(1, static_cast<int>(std::lround(megapixels * 1e6 / width)));
+}
+
+// Input number 'input' of the checks: a synthetic image, posterized to 4 levels per channel for odd inputs so
+// that most edge weights tie and their order matters.
+static std::vector<uint8_t> makeCheckImage(int width, int height, int input) {
+    std::vector<uint8_t> rgb = makeSyntheticImage(width, height, 12345u + 7919u * input);
+    if (input % 2) {
+        for (uint8_t& value : rgb) value &= 0xC0;
+    }
+    return rgb;
+}
+
+// Compares the output digests of every engine across thread counts. Returns the number of mismatches.
+static int checkDeterminism(const std::vector<double>& sizes, const std::vector<int>& thread_counts, int inputs,
+                            const std::string& engine, const BenchmarkConfig& config) {
+    int mismatches = 0, runs = 0;
+    for (double megapixels : sizes) {
+        int width, height;
+        imageSize(megapixels, width, height);
+        for (int input = 0; input < inputs; ++input) {
+            std::vector<uint8_t> rgb = makeCheckImage(width, height, input);
+            for (const char* name : {"agm", "dijkstra"}) {
+                if (engine != "all" && engine != name) continue;
+                auto digest = name == std::string("agm") ? digestAgm : digestDijkstra;
+                uint64_t reference = digest(rgb, width, height, thread_counts.front(), config);
+                for (size_t t = 1; t < thread_counts.size(); ++t) {
+                    uint64_t result = digest(rgb, width, height, thread_counts[t], config);
+                    runs++;
+                    if (result != reference) {
+                        mismatches++;
+                        std::cerr << "MISMATCH " << name << " " << width << "x" << height << " input " << input << ": "
+                                  << thread_counts[t] << " threads differ from " << thread_counts.front() << std::endl;
+                    }
+                }
+            }
+        }
+    }
+    std::cout << "Determinism check: " << runs << " comparisons, " << mismatches << " mismatches" << std::endl;
+    return mismatches;
+}
+
+// Runs checkDijkstraUpdates on 'inputs' images per size. Returns the number of failed updates.
+static int checkUpdates(const std::vector<double>& sizes, int inputs, const BenchmarkConfig& config) {
+    int failures = 0, images = 0;
+    long long tie_labels = 0;
+    for (double megapixels : sizes) {
+        int width, height;
+        imageSize(megapixels, width, height);
+        for (int input = 0; input < inputs; ++input) {
+            failures += checkDijkstraUpdates(makeCheckImage(width, height, input), width, height, 2654435761u * (input + 1),
+                                             config, tie_labels);
+            images++;
+        }
+    }
+    std::cout << "Update check: " << images << " images, " << failures << " failed updates ("
+              << tie_labels << " pixel labels differ from a full run on ties)" << std::endl;
+    return failures;
+}
+
+int main(int argc, char* argv[]) {
+    BenchmarkConfig config;
+    std::vector<double> sizes = {0.25, 1, 4, 16, 100};
+    int hardware_threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    std::vector<int> thread_counts = {1};
+    if (hardware_threads > 1) thread_counts.push_back(hardware_threads);
+    std::string engine = "all";
+    std::string output_path;
+    std::vector<std::string> queue_images;
+    bool check_determinism = false, check_updates = false, sizes_given = false, threads_given = false;
+    int inputs = 8;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--sizes" && has_value) sizes = parseList<double>(argv[++i]), sizes_given = true;
+        else if (arg == "--threads" && has_value) thread_counts = parseList<int>(argv[++i]), threads_given = true;
+        else if (arg == "--check-determinism") check_determinism = true;
+        else if (arg == "--check-updates") check_updates = true;
+        else if (arg == "--inputs" && has_value) inputs = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--repeat" && has_value) config.repeat = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--engine" && has_value) engine = argv[++i];
+        else if (arg == "--output" && has_value) output_path = argv[++i];
+        else if (arg == "--compare-queues" && has_value) queue_images = parseList<std::string>(argv[++i]);
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--sizes 0.25,1,4,16,100] [--threads 1,8] [--repeat 3]"
+                      << " [--engine agm|dijkstra|all] [--output file.json]" << std::endl;
+            std::cerr << "       " << argv[0] << " --check-determinism [--sizes 0.01,0.05,0.3] [--threads 1,2,3,4,8]"
+                      << " [--inputs 8] [--engine agm|dijkstra|all]" << std::endl;
+            std::cerr << "       " << argv[0] << " --check-updates [--sizes 0.01,0.05,0.3] [--inputs 8]" << std::endl;
+            std::cerr << "       " << argv[0] << " --compare-queues image1.png,image2.png [--repeat 3] [--output file.json]"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    if (check_determinism) {
+        if (!sizes_given) sizes = {0.01, 0.05, 0.3};
+        if (!threads_given) thread_counts = {1, 2, 3, 4, std::max(8, hardware_threads)};
+        if (sizes.empty() || thread_counts.empty()) return 1;
+        return checkDeterminism(sizes, thread_counts, inputs, engine, config) == 0 ? 0 : 1;
+    }
+
+    if (check_updates) {
+        if (!sizes_given) sizes = {0.01, 0.05, 0.3};
+        return checkUpdates(sizes, inputs, config) == 0 ? 0 : 1;
+    }
+
+    std::vector<StageResult> results;
+    for (const std::string& path : queue_images) {
+        std::cerr << "Comparing priority queues on " << path << std::endl;
+        if (!compareDijkstraQueues(path, config, results)) return 1;
+    }
+    if (!queue_images.empty()) sizes.clear();
+
+    for (double megapixels : sizes) {
+        int width, height;
+        imageSize(megapixels, width, height);
+        std::vector<uint8_t> rgb = makeSyntheticImage(width, height);
+
+        for (int threads : thread_counts) {
+            std::cerr << "Benchmarking " << width << "x" << height << " with " << threads << " thread(s)" << std::endl;
+            if (engine == "all" || engine == "agm") benchmarkAgm(rgb, width, height, threads, config, results);
+            if (engine == "all" || engine == "dijkstra") benchmarkDijkstra(rgb, width, height, threads, config, results);
+        }
+    }
+
+    if (output_path.empty()) {
+        writeJson(std::cout, config, results);
+    } else {
+        std::ofstream file(output_path);
+        writeJson(file, config, results);
+        std::cerr << "Results saved to " << output_path << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,4 @@
+g++ -std=c++17 -O2 -Wall -Wno-unused-function -pthread -o benchmark benchmark.cpp AgmStages.cpp DijkstraStages.cpp ../AGM/Disjoint.cpp ../AGM/Segmenter.cpp ../AGM/GaussianBlur.cpp ../AGM/SegmentStats.cpp ../AGM/RegionAdjacency.cpp ../AGM/Instrumentation.cpp -I. -lm
+./benchmark --sizes 0.25,1 --output benchmark_results.json
+./benchmark --check-determinism
+./benchmark --compare-queues ../Dijkstra/images/NjQ5.png,../Dijkstra/images/LWE0LmpwZw.png,../Dijkstra/images/random.jpg
@@ -0,0 +1,44 @@
+#include "Daemon.h"
+
+#include <cstring>
+#include "GaussianBlur.h"
+#include "Parallel.h"
+#include "Segmenter.h"
+
+// Warm state: the image and every scratch buffer survive across requests, so once an image of
+// the largest size and the sigma in use have been seen, AGM requests do not allocate.
+static_assert(sizeof(Pixel) == 3, "Pixel must be packed RGB8");
+
+static Image image(0, 0);
+static SegmentationWorkspace workspace;
+
+void reserveAgm(int width, int height) {
+    image.pixel_data.reserve(static_cast<size_t>(width) * height);
+    workspace.reserve(width, height);
+}
+
+void setAgmThreads(int threads) {
+    Parallel::setThreadCount(threads);
+    Parallel::warmUp();
+}
+
+int segmentAgm(const uint8_t* rgb, int width, int height, double k, float sigma, int32_t* labels) {
+    if (width <= 0 || height <= 0) return -1;
+
+    size_t pixels = static_cast<size_t>(width) * height;
+    image.width = width;
+    image.height = height;
+    image.pixel_data.resize(pixels);
+    memcpy(image.pixel_data.data(), rgb, pixels * 3);
+
+    GaussianBlur::applyGaussianBlurToImage(image, sigma, workspace.blur);
+    Segmenter segmenter(image);
+    const std::vector<int>& result = segmenter.segment(k, workspace);
+
+    int segments = 0;
+    for (size_t i = 0; i < pixels; ++i) {
+        labels[i] = result[i];
+        if (result[i] == static_cast<int>(i)) segments++;
+    }
+    return segments;
+}
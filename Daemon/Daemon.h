@@ -0,0 +1,77 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Wire protocol of the segmentation daemon (native byte order, one request at a time per connection):
+// the client sends a DaemonRequest followed by 'seed_count' DaemonSeed records and receives a DaemonReply.
+// A Dijkstra request without seeds is seeded automatically from the regional minima of the gradient.
+// Labels are not sent through the socket: they are written as int32 (row-major) into a POSIX shared-memory
+// object owned by the connection, named in the reply and valid until the next request on that connection.
+
+const uint32_t DAEMON_MAGIC = 0x44474553; // "SEGD"
+const uint32_t DAEMON_VERSION = 2;
+const uint32_t DAEMON_MAX_SEEDS = 1u << 20;
+
+enum DaemonEngine : uint32_t { ENGINE_AGM = 0, ENGINE_DIJKSTRA = 1 };
+enum DaemonImageSource : uint32_t { SOURCE_FILE = 0, SOURCE_SHARED_MEMORY = 1 };
+
+struct DaemonRequest {
+    uint32_t magic = DAEMON_MAGIC;
+    uint32_t version = DAEMON_VERSION;
+    uint32_t engine = ENGINE_AGM;
+    uint32_t source = SOURCE_FILE;
+    char image[256] = {};       // Image file path, or shared-memory object name ("/name") holding RGB8 pixels
+    int32_t width = 0;          // Size of a shared-memory image (ignored for files)
+    int32_t height = 0;
+    double k = 500.0;           // AGM scale parameter
+    double sigma = 0.8;         // AGM Gaussian blur sigma
+    uint32_t diagonal = 1;      // Dijkstra: 8-connectivity if non-zero
+    uint32_t seed_count = 0;    // Dijkstra seeds following the request
+    uint32_t minima_depth = 0;  // Dijkstra without seeds: only minima at least this deep become seeds (h-minima)
+};
+
+struct DaemonSeed {
+    int32_t x, y, label;
+};
+
+struct DaemonReply {
+    uint32_t magic = DAEMON_MAGIC;
+    int32_t status = 0;          // 0 on success; 'message' explains failures
+    int32_t width = 0;
+    int32_t height = 0;
+    int32_t segments = 0;        // Number of segments (AGM) or seeds used (Dijkstra; minima if seeded automatically)
+    double load_ms = 0;          // Image decode / copy time
+    double segment_ms = 0;       // Segmentation time, labels included
+    char labels[64] = {};        // Shared-memory object with width * height int32 labels
+    uint64_t labels_bytes = 0;   // Size of that object (may exceed the label map; grows, never shrinks)
+    char message[128] = {};
+};
+
+// Engines (separate translation units: both engines define an 'Image' type). AGM keeps its image and
+// buffers between requests; Dijkstra builds its gradient, forest and queues for every request, and its
+// parallel passes start their threads each time.
+// Both write width * height labels into 'labels' and return the number of segments, or -1 on bad input.
+
+// Reserves the AGM image and segmentation buffers for images up to width x height, so the first
+// request only allocates the blur kernel for its sigma.
+void reserveAgm(int width, int height);
+int segmentAgm(const uint8_t* rgb, int width, int height, double k, float sigma, int32_t* labels);
+// Dijkstra without seeds uses the regional minima of depth >= minimaDepth and returns their count.
+int segmentDijkstra(const uint8_t* rgb, int width, int height, const std::vector<DaemonSeed>& seeds, int minimaDepth,
+                    bool diagonal, int32_t* labels);
+// Worker thread counts of each engine (the AGM pool threads are started right away).
+void setAgmThreads(int threads);
+void setDijkstraThreads(int threads);
+
+// Reads / writes exactly 'size' bytes, retrying on EINTR and short transfers. False on error or end of stream.
+bool readExact(int fd, void* data, size_t size);
+bool writeExact(int fd, const void* data, size_t size);
+
+// Connects to the daemon socket at 'path'. Returns -1 on failure.
+int connectDaemon(const std::string& path);
+
+#endif // DAEMON_H
@@ -0,0 +1,50 @@
+#include "Daemon.h"
+
+#include <cstring>
+#include <map>
+
+// The Dijkstra engine is a header-style unity build that defines its own 'Image'; rename it so it can
+// be linked next to AGM, and keep its copy of stb private to this translation unit.
+#define STB_IMAGE_STATIC
+#define STB_IMAGE_WRITE_STATIC
+#define Image DijkstraImage
+#include "../Dijkstra/src/dijkstra.cpp"
+#include "../Dijkstra/src/gradient.cpp"
+#include "../Dijkstra/src/regionalMinima.cpp"
+#undef Image
+
+void setDijkstraThreads(int threads) {
+    parallel::setThreadCount(threads);
+}
+
+// Nothing is kept between requests: the gradient, the forest and the queues are built per call.
+int segmentDijkstra(const uint8_t* rgb, int width, int height, const std::vector<DaemonSeed>& seeds, int minimaDepth,
+                    bool diagonal, int32_t* labels) {
+    if (width <= 0 || height <= 0) return -1;
+
+    ImageView source(rgb, width, height, 3); // The request's pixels are read in place
+    DijkstraImage gradientImage(gradient::generateGradient(source));
+    EuclidianDistance_EdgeCost edgeCost(gradientImage);
+
+    if (seeds.empty()) { // Unattended: one seed region per regional minimum, straight into the queue
+        int minima = 0;
+        CM cm(gradientImage, regionalMinima::markers(gradientImage, minimaDepth, diagonal, &minima), diagonal);
+        cm.edgeCost = &edgeCost;
+        cm.run();
+        memcpy(labels, cm.labels.data(), cm.labels.size() * sizeof(int32_t));
+        return minima;
+    }
+
+    std::map<int, int> seedMap;
+    for (const DaemonSeed& seed : seeds) {
+        if (seed.x < 0 || seed.x >= width || seed.y < 0 || seed.y >= height) return -1;
+        seedMap[seed.y * width + seed.x] = seed.label;
+    }
+
+    CM cm(gradientImage, seedMap, diagonal);
+    cm.edgeCost = &edgeCost;
+    cm.run();
+
+    memcpy(labels, cm.labels.data(), cm.labels.size() * sizeof(int32_t));
+    return static_cast<int>(seedMap.size());
+}
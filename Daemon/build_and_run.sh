@@ -0,0 +1,7 @@
+g++ -std=c++17 -O2 -Wall -Wno-unused-function -pthread -o segmentation_daemon daemon.cpp DaemonSocket.cpp AgmEngine.cpp DijkstraEngine.cpp ../AGM/Disjoint.cpp ../AGM/Segmenter.cpp ../AGM/GaussianBlur.cpp ../AGM/SegmentStats.cpp ../AGM/Instrumentation.cpp -I. -I../AGM -lm -lrt
+g++ -std=c++17 -O2 -Wall -pthread -o segmentation_client client.cpp DaemonSocket.cpp ../AGM/LabelExport.cpp -I. -I../AGM -lm -lrt
+./segmentation_daemon --socket /tmp/segmentation.sock &
+sleep 1
+./segmentation_client --socket /tmp/segmentation.sock --image "../AGM/n sei.png" --engine agm --shm --repeat 5
+./segmentation_client --socket /tmp/segmentation.sock --image "../AGM/n sei.png" --engine dijkstra --shm --repeat 5 --output labels.npy
+kill %1
@@ -0,0 +1,160 @@
+// Command-line client for the segmentation daemon: sends the same request 'repeat' times over one
+// connection and reports the round trip, the server-side times and the remaining protocol overhead.
+//
+// Usage: segmentation_client --image file.png [--socket /tmp/segmentation.sock] [--engine agm|dijkstra]
+//                            [--shm] [--k 500] [--sigma 0.8] [--seeds 4] [--depth 0] [--repeat 10] [--output labels.npy]
+//
+// --seeds 0 sends no Dijkstra seeds: the daemon seeds from the regional minima at least --depth deep.
+
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "Daemon.h"
+#include "LabelExport.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+int main(int argc, char* argv[]) {
+    std::string socket_path = "/tmp/segmentation.sock";
+    std::string image_path, output_path;
+    std::string engine = "agm";
+    bool use_shm = false;
+    int seed_grid = 4, repeat = 10;
+    DaemonRequest request;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--image" && has_value) image_path = argv[++i];
+        else if (arg == "--socket" && has_value) socket_path = argv[++i];
+        else if (arg == "--engine" && has_value) engine = argv[++i];
+        else if (arg == "--shm") use_shm = true;
+        else if (arg == "--k" && has_value) request.k = std::atof(argv[++i]);
+        else if (arg == "--sigma" && has_value) request.sigma = std::atof(argv[++i]);
+        else if (arg == "--seeds" && has_value) seed_grid = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--depth" && has_value) request.minima_depth = static_cast<uint32_t>(std::max(0, std::atoi(argv[++i])));
+        else if (arg == "--repeat" && has_value) repeat = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--output" && has_value) output_path = argv[++i];
+        else image_path.clear(), i = argc; // Unknown option: print the usage below
+    }
+    if (image_path.empty() || (engine != "agm" && engine != "dijkstra")) {
+        std::cerr << "Usage: " << argv[0] << " --image file.png [--socket path] [--engine agm|dijkstra] [--shm]"
+                  << " [--k 500] [--sigma 0.8] [--seeds 4] [--depth 0] [--repeat 10] [--output labels.npy]" << std::endl;
+        return 1;
+    }
+    request.engine = engine == "agm" ? ENGINE_AGM : ENGINE_DIJKSTRA;
+
+    // The image is decoded here only to size the seeds grid or to fill the shared-memory input
+    int width = 0, height = 0, channels = 0;
+    unsigned char* rgb = stbi_load(image_path.c_str(), &width, &height, &channels, 3);
+    if (!rgb) {
+        std::cerr << "Error: could not load " << image_path << std::endl;
+        return 1;
+    }
+
+    std::string input_name = "/segc-" + std::to_string(getpid());
+    if (use_shm) {
+        size_t bytes = static_cast<size_t>(width) * height * 3;
+        int fd = shm_open(input_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        void* data = fd >= 0 && ftruncate(fd, static_cast<off_t>(bytes)) == 0
+            ? mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+        if (data == MAP_FAILED) {
+            std::cerr << "Error: could not create the shared-memory image " << input_name << std::endl;
+            return 1;
+        }
+        memcpy(data, rgb, bytes);
+        munmap(data, bytes);
+        close(fd);
+        request.source = SOURCE_SHARED_MEMORY;
+        request.width = width;
+        request.height = height;
+        snprintf(request.image, sizeof(request.image), "%s", input_name.c_str());
+    } else {
+        // The daemon may run in another directory
+        char absolute[PATH_MAX];
+        std::string path = realpath(image_path.c_str(), absolute) ? absolute : image_path;
+        if (path.size() >= sizeof(request.image)) {
+            std::cerr << "Error: image path too long for a request" << std::endl;
+            return 1;
+        }
+        memcpy(request.image, path.c_str(), path.size() + 1);
+    }
+    stbi_image_free(rgb);
+
+    // Dijkstra seeds: seed_grid x seed_grid regular grid, labels 1..n (none for seed_grid 0)
+    std::vector<DaemonSeed> seeds;
+    if (request.engine == ENGINE_DIJKSTRA) {
+        for (int gy = 0; gy < seed_grid; ++gy) {
+            for (int gx = 0; gx < seed_grid; ++gx) {
+                seeds.push_back({(2 * gx + 1) * width / (2 * seed_grid), (2 * gy + 1) * height / (2 * seed_grid),
+                                 static_cast<int32_t>(seeds.size()) + 1});
+            }
+        }
+    }
+    request.seed_count = static_cast<uint32_t>(seeds.size());
+
+    int fd = connectDaemon(socket_path);
+    if (fd < 0) {
+        std::cerr << "Error: could not connect to " << socket_path << std::endl;
+        if (use_shm) shm_unlink(input_name.c_str());
+        return 1;
+    }
+
+    DaemonReply reply;
+    const int32_t* labels = nullptr;
+    size_t mapped_bytes = 0;
+    int status = 0;
+    for (int i = 0; i < repeat && status == 0; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        if (!writeExact(fd, &request, sizeof(request)) ||
+            (!seeds.empty() && !writeExact(fd, seeds.data(), seeds.size() * sizeof(DaemonSeed))) ||
+            !readExact(fd, &reply, sizeof(reply))) {
+            std::cerr << "Error: connection to the daemon lost" << std::endl;
+            status = 1;
+            break;
+        }
+        double round_trip_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (reply.status != 0) {
+            std::cerr << "Error: " << reply.message << std::endl;
+            status = 1;
+            break;
+        }
+        std::cout << "request " << i << ": " << reply.width << "x" << reply.height << ", " << reply.segments << " segments, round trip "
+                  << round_trip_ms << " ms (load " << reply.load_ms << " ms, segment " << reply.segment_ms << " ms, overhead "
+                  << round_trip_ms - reply.load_ms - reply.segment_ms << " ms)" << std::endl;
+
+        // The label object only changes size when a larger image comes in
+        if (reply.labels_bytes != mapped_bytes) {
+            if (labels) munmap(const_cast<int32_t*>(labels), mapped_bytes);
+            labels = nullptr;
+            mapped_bytes = 0;
+            int labels_fd = shm_open(reply.labels, O_RDONLY, 0);
+            void* data = labels_fd >= 0 ? mmap(nullptr, reply.labels_bytes, PROT_READ, MAP_SHARED, labels_fd, 0) : MAP_FAILED;
+            if (labels_fd >= 0) close(labels_fd);
+            if (data == MAP_FAILED) {
+                std::cerr << "Error: could not map the labels " << reply.labels << std::endl;
+                status = 1;
+                break;
+            }
+            labels = static_cast<const int32_t*>(data);
+            mapped_bytes = reply.labels_bytes;
+        }
+    }
+
+    if (status == 0 && labels && !output_path.empty()) {
+        std::vector<int> label_map(labels, labels + static_cast<size_t>(reply.width) * reply.height);
+        if (!LabelExport::writeNpy(label_map, reply.width, reply.height, output_path)) status = 1;
+    }
+
+    if (labels) munmap(const_cast<int32_t*>(labels), mapped_bytes);
+    close(fd);
+    if (use_shm) shm_unlink(input_name.c_str());
+    return status;
+}
@@ -0,0 +1,216 @@
+// Long-running segmentation server for both engines.
+// Keeps the AGM thread pool and workspaces warm and answers requests over a Unix domain socket;
+// label maps are returned through shared memory (see Daemon.h for the protocol).
+//
+// Usage: segmentation_daemon [--socket /tmp/segmentation.sock] [--threads N] [--reserve 1920x1080]
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "Daemon.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void onSignal(int) {
+    stop_requested = 1;
+}
+
+// Label buffer of one connection: a shared-memory object that only grows, so steady-state
+// requests of the same size reuse the same mapping on both sides.
+struct LabelBuffer {
+    std::string name;
+    int fd = -1;
+    void* data = nullptr;
+    size_t bytes = 0;
+
+    bool reserve(size_t needed) {
+        if (needed <= bytes) return true;
+        if (data) munmap(data, bytes);
+        data = nullptr;
+        if (ftruncate(fd, static_cast<off_t>(needed)) != 0) return false;
+        data = mmap(nullptr, needed, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            data = nullptr;
+            bytes = 0;
+            return false;
+        }
+        bytes = needed;
+        return true;
+    }
+
+    void release() {
+        if (data) munmap(data, bytes);
+        if (fd >= 0) close(fd);
+        shm_unlink(name.c_str());
+        data = nullptr;
+        fd = -1;
+        bytes = 0;
+    }
+};
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void fail(DaemonReply& reply, const char* message) {
+    reply.status = 1;
+    snprintf(reply.message, sizeof(reply.message), "%s", message);
+}
+
+// Answers one request. The reply is filled in every case; returns false only if the connection broke.
+static bool serveRequest(int client, LabelBuffer& buffer, std::vector<DaemonSeed>& seeds) {
+    DaemonRequest request;
+    if (!readExact(client, &request, sizeof(request))) return false;
+    DaemonReply reply;
+    if (request.magic != DAEMON_MAGIC || request.version != DAEMON_VERSION || request.seed_count > DAEMON_MAX_SEEDS) {
+        fail(reply, "unsupported request");
+        writeExact(client, &reply, sizeof(reply));
+        return false; // The stream cannot be trusted any more
+    }
+    seeds.resize(request.seed_count);
+    if (request.seed_count > 0 && !readExact(client, seeds.data(), seeds.size() * sizeof(DaemonSeed))) return false;
+    request.image[sizeof(request.image) - 1] = '\0';
+
+    // 1. Image: decoded from a file, or read in place from the client's shared memory
+    auto start = std::chrono::steady_clock::now();
+    const uint8_t* rgb = nullptr;
+    unsigned char* decoded = nullptr;
+    void* mapped = nullptr;
+    size_t mapped_bytes = 0;
+    int width = 0, height = 0;
+    if (request.source == SOURCE_FILE) {
+        int channels = 0;
+        decoded = stbi_load(request.image, &width, &height, &channels, 3);
+        rgb = decoded;
+        if (!decoded) fail(reply, "could not load the image file");
+    } else if (request.source == SOURCE_SHARED_MEMORY) {
+        width = request.width;
+        height = request.height;
+        mapped_bytes = static_cast<size_t>(std::max(0, width)) * std::max(0, height) * 3;
+        int fd = shm_open(request.image, O_RDONLY, 0);
+        struct stat info;
+        if (fd < 0 || mapped_bytes == 0 || fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < mapped_bytes) {
+            fail(reply, "could not open the shared-memory image");
+        } else {
+            mapped = mmap(nullptr, mapped_bytes, PROT_READ, MAP_SHARED, fd, 0);
+            if (mapped == MAP_FAILED) {
+                mapped = nullptr;
+                fail(reply, "could not map the shared-memory image");
+            }
+            rgb = static_cast<const uint8_t*>(mapped);
+        }
+        if (fd >= 0) close(fd);
+    } else {
+        fail(reply, "unknown image source");
+    }
+    reply.load_ms = millisecondsSince(start);
+
+    // 2. Segmentation, straight into the connection's label buffer
+    if (rgb) {
+        reply.width = width;
+        reply.height = height;
+        if (!buffer.reserve(static_cast<size_t>(width) * height * sizeof(int32_t))) {
+            fail(reply, "could not grow the label buffer");
+        } else {
+            start = std::chrono::steady_clock::now();
+            int32_t* labels = static_cast<int32_t*>(buffer.data);
+            if (request.engine == ENGINE_AGM) {
+                reply.segments = segmentAgm(rgb, width, height, request.k, static_cast<float>(request.sigma), labels);
+            } else if (request.engine == ENGINE_DIJKSTRA) {
+                reply.segments = segmentDijkstra(rgb, width, height, seeds, static_cast<int>(request.minima_depth),
+                                                 request.diagonal != 0, labels);
+            } else {
+                reply.segments = -1;
+            }
+            reply.segment_ms = millisecondsSince(start);
+            if (reply.segments < 0) fail(reply, "invalid engine, image or seeds");
+        }
+    }
+    if (decoded) stbi_image_free(decoded);
+    if (mapped) munmap(mapped, mapped_bytes);
+
+    snprintf(reply.labels, sizeof(reply.labels), "%s", buffer.name.c_str());
+    reply.labels_bytes = buffer.bytes;
+    return writeExact(client, &reply, sizeof(reply));
+}
+
+int main(int argc, char* argv[]) {
+    std::string socket_path = "/tmp/segmentation.sock";
+    int threads = 0;
+    int reserve_width = 0, reserve_height = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--socket" && has_value) socket_path = argv[++i];
+        else if (arg == "--threads" && has_value) threads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--reserve" && has_value && sscanf(argv[++i], "%dx%d", &reserve_width, &reserve_height) == 2) {}
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--socket /tmp/segmentation.sock] [--threads N] [--reserve WIDTHxHEIGHT]" << std::endl;
+            return 1;
+        }
+    }
+
+    // Warm-up: the AGM pool threads and workspaces exist before the first request (Dijkstra only takes the thread count)
+    setAgmThreads(threads);
+    setDijkstraThreads(threads);
+    if (reserve_width > 0 && reserve_height > 0) reserveAgm(reserve_width, reserve_height);
+
+    struct sigaction action = {};
+    action.sa_handler = onSignal; // No SA_RESTART: accept() returns so the loop can stop
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (server < 0 || socket_path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Error: could not create the socket " << socket_path << std::endl;
+        return 1;
+    }
+    memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+    unlink(socket_path.c_str());
+    if (bind(server, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(server, 16) != 0) {
+        std::cerr << "Error: could not listen on " << socket_path << ": " << strerror(errno) << std::endl;
+        return 1;
+    }
+    std::cout << "Listening on " << socket_path << std::endl;
+
+    // Connections are served one at a time, each until its client disconnects; other clients wait in the
+    // listen backlog meanwhile. Requests share the warm engines, which are not thread-safe.
+    std::vector<DaemonSeed> seeds;
+    int connection_count = 0;
+    while (!stop_requested) {
+        int client = accept(server, nullptr, nullptr);
+        if (client < 0) continue; // EINTR on shutdown, or a transient error
+
+        LabelBuffer buffer;
+        buffer.name = "/segd-" + std::to_string(getpid()) + "-" + std::to_string(connection_count++);
+        buffer.fd = shm_open(buffer.name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (buffer.fd >= 0) {
+            while (!stop_requested && serveRequest(client, buffer, seeds)) {
+            }
+        } else {
+            std::cerr << "Error: could not create the shared-memory object " << buffer.name << std::endl;
+        }
+        buffer.release();
+        close(client);
+    }
+
+    close(server);
+    unlink(socket_path.c_str());
+    return 0;
+}
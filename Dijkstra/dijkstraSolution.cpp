@@ -4,6 +4,7 @@
 #include <limits>
 #include <algorithm>
 #include "src/gradient.cpp"
+#include "src/labelExport.cpp"
 
 // For Windows-specific functionality (ShellExecute) - Optional, but more robust
 #ifdef _WIN32
@@ -91,7 +92,7 @@ void openPhoto(const std::string &imagePath)
 #endif
 }
 
-int xyToPos(Image image, int x, int y)
+int xyToPos(ImageView image, int x, int y)
 {
     if (x < 0 || x >= image.w || y < 0 || y >= image.h)
         return -1;          // Invalid position
@@ -135,7 +136,7 @@ void exibirSeeds(const std::map<int, int> &seeds, int imageWidth)
 }
 
 // --| CRUD |--
-void crudSeeds(std::map<int, int> &seeds, const Image &image)
+void crudSeeds(std::map<int, int> &seeds, ImageView image)
 {
     int choice = 0;
 
@@ -393,5 +394,17 @@ int main()
     outputImage.write("output\\output.png"); // Write the output image to a file
     printf("Output image written to output\\output.png\n");
 
+    // Raw label maps, written straight from cm.labels (-1 = unlabeled)
+    if (labelExport::writeNpy(cm.labels, image.w, image.h, "output\\labels.npy"))
+        printf("Label map written to output\\labels.npy\n");
+    if (labelExport::writeRLE(cm.labels, image.w, image.h, "output\\labels.rle"))
+        printf("Label map written to output\\labels.rle\n");
+
+    std::vector<SegmentStat> segmentTable = cm.statistics(image);
+    if (segmentStats::writeCSV(segmentTable, "output\\segments.csv"))
+        printf("Segment statistics written to output\\segments.csv\n");
+    if (regionAdjacency::writeCSV(cm.adjacency(), "output\\adjacency.csv"))
+        printf("Region adjacency graph written to output\\adjacency.csv\n");
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,59 @@
+#ifndef BUCKET_QUEUE_CPP
+#define BUCKET_QUEUE_CPP
+
+#include <cstdint>
+#include <vector>
+
+/// @brief Circular bucket queue (Dial) over element ids with integer keys
+/// @details A key pushed must be at least the last popped key and at most maxStep above it; the maxStep + 1
+///          buckets, indexed by key modulo their count, then never hold two different keys. Push and pop are O(1)
+///          amortized and equal keys pop in insertion order. An id may be queued several times; dropping the
+///          outdated copies is up to the caller.
+class BucketQueue
+{
+public:
+    // _________________________________________________________________________________________________________________
+    /// @brief Empties the queue and sizes it for edge steps up to maxStep
+    void reset(int maxStep)
+    {
+        buckets.assign(maxStep + 1, std::vector<int>());
+        cursor = 0;
+        front = 0;
+        count = 0;
+    }
+
+    bool empty() const { return count == 0; }
+
+    // _________________________________________________________________________________________________________________
+    /// @brief Inserts 'id' with 'key'
+    void push(int id, uint32_t key)
+    {
+        buckets[key % buckets.size()].push_back(id);
+        count++;
+    }
+
+    // _________________________________________________________________________________________________________________
+    /// @brief Removes and returns the oldest id with the smallest key, which is stored in 'key'
+    int pop(uint32_t &key)
+    {
+        std::vector<int> *bucket = &buckets[cursor % buckets.size()];
+        while (front == bucket->size())
+        {
+            bucket->clear(); // Drained; keeps its capacity for the key that wraps around to it
+            front = 0;
+            cursor++;
+            bucket = &buckets[cursor % buckets.size()];
+        }
+        count--;
+        key = cursor;
+        return (*bucket)[front++];
+    }
+
+private:
+    std::vector<std::vector<int>> buckets; // Ids queued with each key modulo the bucket count
+    uint32_t cursor = 0;                   // Smallest key that can still be queued
+    size_t front = 0;                      // Next entry to pop in the cursor's bucket
+    size_t count = 0;
+};
+
+#endif
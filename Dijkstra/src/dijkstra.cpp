@@ -1,142 +1,502 @@
 #include "edgeCost.cpp"
+#include "segmentStats.cpp"
+#include "regionAdjacency.cpp"
+#include "indexedHeap.cpp"
+#include "bucketQueue.cpp"
+#include "radixHeap.cpp"
+#include "neighborhood.cpp"
+#include "weightPlanes.cpp"
+#include "pathCost.cpp"
 
 #include <map>     // for std::map
 #include <utility> // for std::pair
-#include <queue>   // for std::queue
 #include <set>
 #include <string>
 #include <iostream>
 
-std::vector<int> getEdjacentVertices(int pos, int width, int height, bool useDiagonal)
+/// @brief Priority queue used by CM::run
+enum class PathQueue
 {
-    std::vector<int> result;
-    int x = pos % width;
-    int y = pos / width;
-
-    if (y > 0)
-    {
-        result.push_back(pos - width);
-        if (useDiagonal)
-        {
-            if (x > 0)
-            {
-                result.push_back(pos - width - 1);
-            }
-            if (x < width - 1)
-            {
-                result.push_back(pos - width + 1);
-            }
-        }
-    }
-    if (x > 0)
-    {
-        result.push_back(pos - 1);
-    }
-    if (x < width - 1)
-    {
-        result.push_back(pos + 1);
-    }
-    if (y < height - 1)
-    {
-        result.push_back(pos + width);
-        if (useDiagonal)
-        {
-            if (x > 0)
-            {
-                result.push_back(pos + width - 1);
-            }
-            if (x < width - 1)
-            {
-                result.push_back(pos + width + 1);
-            }
-        }
-    }
-
-    return result;
-}
+    Automatic, // Buckets for integer bounded costs, radix heap otherwise
+    Heap,      // Indexed 4-ary heap with decrease-key
+    Buckets,   // Bucket queue; falls back to the heap if the costs are not integer bounded
+    Radix      // Monotone radix heap with lazy deletion
+};
 
-struct PixelNode
+// _____________________________________________________________________________________________________________________
+/// @brief Calls visit(policy) with the cost policy for 'cost' (see visitCostPolicy) whose weights are the ones CM::run
+///        reads with 'weights': uint8 planes round and saturate float costs, so the policy rounds them the same way
+template <typename Visit>
+void visitWeightPolicy(const EdgeCost *cost, EdgeWeights weights, Visit visit)
 {
-    int index;  // Linear index of pixel
-    float cost; // Cost to reach this pixel
-
-    // Reverse order for min-heap behavior
-    bool operator<(const PixelNode &other) const
-    {
-        return cost > other.cost;
-    }
-};
+    visitCostPolicy(cost, [&](const auto &policy)
+                    {
+        if (weights == EdgeWeights::Uint8 && policy.symmetric())
+            visit(RoundedCostPolicy<std::decay_t<decltype(policy)>>{policy});
+        else
+            visit(policy); });
+}
 
 class CM
 {
 public:
-    Image image;
+    ImageView image; // Not owned; the image must outlive the CM
     bool useDiagonal = false; // Use diagonal connections if true
 
     std::map<int, int> seeds; // Map of seed positions to their labels
+    std::vector<int> markers; // Per-pixel seed labels (-1 = not a seed), e.g. from regionalMinima; empty if unused
     std::vector<int> labels;  // Labels for each pixel in the image
     std::vector<float> costs; // costs for each pixel in the image
     std::vector<int> parent;  // Parent pixel for each pixel in the image
+    Image finalized;          // Sentinel-bordered mask (see makePaddedMask): 1 once a pixel's optimum path is known
 
-    std::priority_queue<PixelNode> queue; // Queue for BFS or Dijkstra's algorithm
+    IndexedHeap<4> queue; // Pixels with a tentative cost, at most one entry each
 
     EdgeCost *edgeCost = nullptr; // Pointer to the edge cost function
+    PathQueue pathQueue = PathQueue::Automatic;
+    PathCost pathCost = PathCost::Sum; // fsum or fmax
+    EdgeWeights edgeWeights = EdgeWeights::OnTheFly; // Precompute weight planes before the queue starts (symmetric costs only);
+                                                     // updateSeeds repairs with the same (rounded) weights, without planes
+
+    /// @brief Integer costs up to this bound use the bucket queue
+    static const int maxBucketCost = 1 << 16;
 
     // _________________________________________________________________________________________________________________
     /// @brief Constructor for the CM class
-    CM(Image image, std::map<int, int> seeds, bool useDiagonal = false)
-        : image(image), useDiagonal(useDiagonal), labels(image.w * image.h, -1), costs(image.w * image.h, std::numeric_limits<float>::infinity()), parent(image.w * image.h, -1)
+    CM(ImageView image, const std::map<int, int> &seeds, bool useDiagonal = false)
+        : image(image), useDiagonal(useDiagonal)
     {
-        // Initialize labels based on seeds
         for (const auto &seed : seeds)
         {
             if (seed.first < 0 || seed.first >= image.w * image.h)
                 continue; // Skip invalid seed positions
 
-            labels[seed.first] = seed.second;
-            costs[seed.first] = 0.0f; // Set initial cost for seed pixels
-            queue.push(PixelNode{seed.first, 0.0f});
-
             this->seeds.insert_or_assign(seed.first, seed.second); // add seed to the map
         }
+        initialize();
+    }
+
+    /// @brief Constructor for many seeds: every pixel with a non-negative marker is a seed with that label
+    /// @details The markers go straight into the queue, without a seeds map. updateSeeds() keeps them as seeds.
+    CM(ImageView image, std::vector<int> markers, bool useDiagonal = false)
+        : image(image), useDiagonal(useDiagonal), markers(std::move(markers))
+    {
+        initialize();
     }
 
     // _________________________________________________________________________________________________________________
     /// @brief Run the connected components algorithm using BFS or Dijkstra's algorithm
-    /// @details This function processes the queue, updating labels and costs for each pixel based on the edge cost.
+    /// @details Path costs follow pathCost and the queue follows pathQueue. Automatic runs integer edge costs with a
+    ///          small bound (EdgeCost::maxIntegerCost) on a bucket queue in linear time and anything else on the radix
+    ///          heap. Under fmax a path never costs more than its largest arc, so an 8-bit cost needs only 256 buckets.
+    ///          Every queue produces an optimum-path forest with the same costs; labels may differ on ties.
+    void run()
+    {
+        if (useDiagonal)
+            run<true>();
+        else
+            run<false>();
+    }
+
+    /// @brief True once the optimum path of pixel 'pos' is known
+    bool isFinalized(int pos) const { return *maskCell(finalized, pos) != 0; }
+
+    // _________________________________________________________________________________________________________________
+    /// @brief run() for a fixed connectivity (8 if Diagonal, 4 otherwise)
+    template <bool Diagonal>
     void run()
     {
+        visitCostPolicy(edgeCost, [&](const auto &cost)
+                        {
+            if (pathCost == PathCost::Max)
+                this->template run<Diagonal, MaxPathCost>(cost);
+            else
+                this->template run<Diagonal, SumPathCost>(cost); });
+        forestReady = true;
+    }
+
+    // _________________________________________________________________________________________________________________
+    /// @brief Differential IFT: changes the seed set to 'newSeeds' and repairs the forest of the last run in place
+    /// @details Only the trees of removed seeds are reset (a seed whose label changed is removed and added again).
+    ///          Their neighbors in the remaining trees and the added seeds are then propagated on the radix heap, so
+    ///          the work follows the area that changes hands rather than the image size. Costs match a full run
+    ///          with 'newSeeds'; labels may differ on ties, but always follow the parent pointers to a seed of
+    ///          that label (checked by the benchmark's --check-updates). Edge weights are computed on the fly, but
+    ///          rounded as uint8 planes would be when edgeWeights is Uint8 (see visitWeightPolicy), so the repaired
+    ///          area uses the same weights as the rest of the forest. Without a previous run this is a full run.
+    /// @return Number of pixels whose path was computed again
+    int updateSeeds(const std::map<int, int> &newSeeds)
+    {
+        std::map<int, int> valid;
+        for (const auto &seed : newSeeds)
+        {
+            if (seed.first < 0 || seed.first >= image.w * image.h)
+                continue; // Skip invalid seed positions
+            valid.insert_or_assign(seed.first, seed.second);
+        }
+        if (!forestReady)
+        {
+            seeds = std::move(valid);
+            initialize();
+            run();
+            return image.w * image.h;
+        }
+
+        std::vector<int> removed, added;
+        for (const auto &seed : seeds)
+        {
+            auto kept = valid.find(seed.first);
+            if (kept == valid.end() || kept->second != seed.second)
+            {
+                removed.push_back(seed.first);
+                if (kept == valid.end() && !markers.empty() && markers[seed.first] >= 0)
+                    added.push_back(seed.first); // Back to its marker
+            }
+        }
+        for (const auto &seed : valid)
+        {
+            auto old = seeds.find(seed.first);
+            if (old == seeds.end() || old->second != seed.second)
+                added.push_back(seed.first);
+        }
+        seeds = std::move(valid);
+
+        int recomputed = 0;
+        visitWeightPolicy(edgeCost, edgeWeights, [&](const auto &cost)
+                          {
+            if (pathCost == PathCost::Max)
+                recomputed = useDiagonal ? this->template updateForest<true, MaxPathCost>(cost, removed, added)
+                                         : this->template updateForest<false, MaxPathCost>(cost, removed, added);
+            else
+                recomputed = useDiagonal ? this->template updateForest<true, SumPathCost>(cost, removed, added)
+                                         : this->template updateForest<false, SumPathCost>(cost, removed, added); });
+        return recomputed;
+    }
+
+    // _________________________________________________________________________________________________________________
+    /// @brief updateSeeds() for a fixed connectivity, path-cost function and cost policy; returns the pixels computed again
+    template <bool Diagonal, typename Path, typename Cost>
+    int updateForest(const Cost &cost, const std::vector<int> &removed, const std::vector<int> &added)
+    {
+        const Neighborhood<Diagonal> neighborhood(image.w);
+        if (frame.w != image.w || frame.h != image.h)
+            frame = makePaddedMask(image.w, image.h); // Border only: previous paths may be taken over
+        const float infinity = std::numeric_limits<float>::infinity();
+
+        // - - - - - - - - - - - - - - - - - - - - - - - -
+        // Trees of the removed seeds, walked down the parent pointers (a child is always a neighbor of its parent)
+        std::vector<int> reset;
+        for (int seed : removed)
+        {
+            size_t first = reset.size();
+            reset.push_back(seed);
+            for (size_t i = first; i < reset.size(); i++)
+            {
+                int current = reset[i];
+                neighborhood.forEachOpen(current, frame, [&](int neighbor, int)
+                {
+                    if (parent[neighbor] == current)
+                        reset.push_back(neighbor);
+                });
+            }
+        }
+        for (int pos : reset)
+        {
+            labels[pos] = -1;
+            costs[pos] = infinity;
+            parent[pos] = -1;
+            *maskCell(finalized, pos) = 0;
+        }
+
+        // - - - - - - - - - - - - - - - - - - - - - - - -
+        // The reset area is bid for again by its neighbors in the remaining trees, at their current costs,
+        // and by the added seeds
+        RadixHeap radix;
+        radix.reset((int)(reset.size() + added.size()));
+        for (int pos : reset)
+        {
+            neighborhood.forEachOpen(pos, maskIndex(pos, image.w), frame, [&](int neighbor, int, int neighborIndex)
+            {
+                uint8_t &done = finalized.data[neighborIndex];
+                if (done && costs[neighbor] < infinity)
+                {
+                    done = 0; // Queued once
+                    radix.push(neighbor, costs[neighbor]);
+                }
+            });
+        }
+        for (int seed : added)
+        {
+            auto mapped = seeds.find(seed);
+            labels[seed] = mapped != seeds.end() ? mapped->second : markers[seed];
+            costs[seed] = 0.0f;
+            parent[seed] = -1;
+            *maskCell(finalized, seed) = 0;
+            radix.push(seed, 0.0f);
+        }
+
+        // - - - - - - - - - - - - - - - - - - - - - - - -
+        // As runRadixHeap, except that pixels finalized by the last run can still be taken over by a cheaper path.
+        // A pixel whose parent changed label also follows it when its cost only ties (fmax, zero-weight arcs), so
+        // labels always follow the parent pointers and a later reset walk still finds every pixel of a tree.
+        int recomputed = 0;
+        while (!radix.empty())
+        {
+            float currentCost;
+            int current = radix.pop(currentCost);
+            int index = maskIndex(current, image.w);
+            uint8_t &done = finalized.data[index];
+            if (done)
+                continue; // Stale entry, the pixel was reached more cheaply
+            done = 1;
+            recomputed++;
+
+            int currentLabel = labels[current];
+            neighborhood.forEachOpen(current, index, frame, [&](int neighbor, int direction, int neighborIndex)
+            {
+                float newCost = Path::extend(currentCost, cost(current, neighbor, direction));
+                if (newCost < costs[neighbor] || (parent[neighbor] == current && labels[neighbor] != currentLabel))
+                {
+                    costs[neighbor] = newCost;
+                    labels[neighbor] = currentLabel;
+                    parent[neighbor] = current;
+                    finalized.data[neighborIndex] = 0;
+                    radix.push(neighbor, newCost);
+                }
+            });
+        }
+        return recomputed;
+    }
+
+    // _________________________________________________________________________________________________________________
+    /// @brief run() for a fixed connectivity, path-cost function (SumPathCost, MaxPathCost) and static cost policy
+    ///        (see visitCostPolicy)
+    /// @details With edgeWeights set and a symmetric cost, the weights are first precomputed into WeightPlanes.
+    ///          Integer costs up to 255 always get uint8 planes, which are exact for them.
+    template <bool Diagonal, typename Path, typename Cost>
+    void run(const Cost &cost)
+    {
+        int maxCost = edgeCost ? edgeCost->maxIntegerCost() : 1; // Unit cost without an edge cost function
+        if (edgeWeights != EdgeWeights::OnTheFly && cost.symmetric())
+        {
+            if (edgeWeights == EdgeWeights::Uint8 || (maxCost >= 0 && maxCost <= 255))
+            {
+                WeightPlanes<uint8_t, Diagonal> planes(cost, image.w, image.h);
+                runQueue<Diagonal, Path>(PlaneCostPolicy<uint8_t, Diagonal>{&planes}, maxCost >= 0 ? maxCost : 255);
+            }
+            else
+            {
+                WeightPlanes<float, Diagonal> planes(cost, image.w, image.h);
+                runQueue<Diagonal, Path>(PlaneCostPolicy<float, Diagonal>{&planes}, maxCost);
+            }
+            return;
+        }
+        runQueue<Diagonal, Path>(cost, maxCost);
+    }
+
+    // _________________________________________________________________________________________________________________
+    /// @brief Runs the queue selected by pathQueue; maxCost is the integer cost bound, or -1 for float costs
+    template <bool Diagonal, typename Path, typename Cost>
+    void runQueue(const Cost &cost, int maxCost)
+    {
+        bool bounded = maxCost >= 0 && maxCost <= maxBucketCost;
+        switch (pathQueue)
+        {
+        case PathQueue::Automatic:
+            if (bounded && runBucketQueue<Diagonal, Path>(cost, maxCost))
+                return;
+            runRadixHeap<Diagonal, Path>(cost);
+            return;
+        case PathQueue::Buckets:
+            if (bounded && runBucketQueue<Diagonal, Path>(cost, maxCost))
+                return;
+            runHeap<Diagonal, Path>(cost);
+            return;
+        case PathQueue::Radix:
+            runRadixHeap<Diagonal, Path>(cost);
+            return;
+        case PathQueue::Heap:
+            runHeap<Diagonal, Path>(cost);
+            return;
+        }
+    }
+
+    // _________________________________________________________________________________________________________________
+    /// @brief IFT on the indexed heap
+    /// @details This function processes the queue, updating labels and costs for each pixel based on the edge cost.
+    ///          A pixel is finalized when it is popped; until then a cheaper path can still take it over (decrease-key),
+    ///          so the result is an optimum-path forest.
+    template <bool Diagonal, typename Path, typename Cost>
+    void runHeap(const Cost &cost)
+    {
+        const Neighborhood<Diagonal> neighborhood(image.w);
         while (!queue.empty())
         {
-            int current = queue.top().index; // Get the pixel with the lowest cost from the queue
-            queue.pop();
+            int current = queue.pop(); // Get the pixel with the lowest cost from the queue
+            int index = maskIndex(current, image.w);
+            finalized.data[index] = 1;
 
             int currentLabel = labels[current];
             float currentCost = costs[current];
 
-            std::vector<int> neighbors = getEdjacentVertices(current, image.w, image.h, useDiagonal);
-
             // - - - - - - - - - - - - - - - - - - - - - - - -
-            // Process each neighbor of the current pixel
-            for (int neighbor : neighbors)
+            // Process each neighbor whose path can still improve
+            neighborhood.forEachOpen(current, index, finalized, [&](int neighbor, int direction, int)
             {
-                if (neighbor < 0 || neighbor >= static_cast<int>(labels.size()))
-                    continue; // Skip out-of-bounds neighbors
+                float newCost = Path::extend(currentCost, cost(current, neighbor, direction));
 
-                if (labels[neighbor] == -1) // If the neighbor is unvisited
+                if (newCost < costs[neighbor]) // If the new cost is lower than the previous cost
                 {
-                    float edgeCostValue = edgeCost ? edgeCost->getCost(current, neighbor) : 1.0f; // Default cost if no edge cost function is provided
-                    float newCost = currentCost + edgeCostValue;
+                    costs[neighbor] = newCost;
+                    labels[neighbor] = currentLabel;         // Assign the label of the current pixel to the neighbor
+                    parent[neighbor] = current;              // Set the parent of the neighbor to the current pixel
+                    queue.pushOrDecrease(neighbor, newCost); // Queue it, or move it up if already queued
+                }
+            });
+        }
+    }
 
-                    if (newCost < costs[neighbor]) // If the new cost is lower than the previous cost
-                    {
-                        costs[neighbor] = newCost;
-                        labels[neighbor] = currentLabel;          // Assign the label of the current pixel to the neighbor
-                        parent[neighbor] = current;               // Set the parent of the neighbor to the current pixel
-                        queue.push(PixelNode{neighbor, newCost}); // Add the neighbor to the queue for further processing
-                    }
+    // _________________________________________________________________________________________________________________
+    /// @brief IFT on a circular bucket queue for integer edge costs in [0, maxCost]
+    /// @details Path costs are kept as exact integers. Returns false, with the initial state restored, if a path
+    ///          cost would overflow 32 bits; run() then falls back to the heap.
+    template <bool Diagonal, typename Path, typename Cost>
+    bool runBucketQueue(const Cost &cost, int maxCost)
+    {
+        const Neighborhood<Diagonal> neighborhood(image.w);
+        int pixelCount = image.w * image.h;
+        std::vector<uint32_t> exactCost(pixelCount, UINT32_MAX);
+        BucketQueue buckets;
+        buckets.reset(maxCost);
+        while (!queue.empty()) // Move the seeds over
+        {
+            int seed = queue.pop();
+            exactCost[seed] = (uint32_t)costs[seed];
+            buckets.push(seed, exactCost[seed]);
+        }
+
+        while (!buckets.empty())
+        {
+            uint32_t currentCost;
+            int current = buckets.pop(currentCost);
+            int index = maskIndex(current, image.w);
+            uint8_t &done = finalized.data[index];
+            if (done)
+                continue; // Stale entry, the pixel was reached more cheaply
+            done = 1;
+            if (currentCost > UINT32_MAX - (uint32_t)maxCost)
+            {
+                initialize();
+                return false;
+            }
+
+            int currentLabel = labels[current];
+            neighborhood.forEachOpen(current, index, finalized, [&](int neighbor, int direction, int)
+            {
+                uint32_t step = (uint32_t)std::lround(cost(current, neighbor, direction));
+                uint32_t newCost = Path::extend(currentCost, step);
+                if (newCost < exactCost[neighbor])
+                {
+                    exactCost[neighbor] = newCost;
+                    costs[neighbor] = (float)newCost;
+                    labels[neighbor] = currentLabel;
+                    parent[neighbor] = current;
+                    buckets.push(neighbor, newCost);
                 }
+            });
+        }
+        return true;
+    }
+
+    // _________________________________________________________________________________________________________________
+    /// @brief IFT on a monotone radix heap for any non-negative edge costs
+    /// @details Improved paths are pushed again instead of decreasing a key; entries of finalized pixels are skipped.
+    template <bool Diagonal, typename Path, typename Cost>
+    void runRadixHeap(const Cost &cost)
+    {
+        const Neighborhood<Diagonal> neighborhood(image.w);
+        RadixHeap radix;
+        radix.reset(queue.size());
+        while (!queue.empty()) // Move the seeds over
+        {
+            int seed = queue.pop();
+            radix.push(seed, costs[seed]);
+        }
+
+        while (!radix.empty())
+        {
+            float currentCost;
+            int current = radix.pop(currentCost);
+            int index = maskIndex(current, image.w);
+            uint8_t &done = finalized.data[index];
+            if (done)
+                continue; // Stale entry, the pixel was reached more cheaply
+            done = 1;
+
+            int currentLabel = labels[current];
+            neighborhood.forEachOpen(current, index, finalized, [&](int neighbor, int direction, int)
+            {
+                float newCost = Path::extend(currentCost, cost(current, neighbor, direction));
+                if (newCost < costs[neighbor])
+                {
+                    costs[neighbor] = newCost;
+                    labels[neighbor] = currentLabel;
+                    parent[neighbor] = current;
+                    radix.push(neighbor, newCost);
+                }
+            });
+        }
+    }
+
+    // _________________________________________________________________________________________________________________
+    /// @brief Per-segment statistics table (area, bounding box, centroid, mean colour) of the current labels
+    /// @param source Image the mean colours are taken from (usually the original, not the gradient); same size as image
+    std::vector<SegmentStat> statistics(ImageView source) const
+    {
+        return segmentStats::compute(labels, source);
+    }
+
+    // _________________________________________________________________________________________________________________
+    /// @brief Region adjacency graph of the current labels, weighted by the edge cost function (1 per pair without one)
+    RegionGraph adjacency() const
+    {
+        RegionGraph graph;
+        visitCostPolicy(edgeCost, [&](const auto &cost)
+                        { graph = regionAdjacency::build(labels, image.w, image.h, cost); });
+        return graph;
+    }
+
+private:
+    bool forestReady = false; // labels, costs and parent hold the forest of the current seeds (see updateSeeds)
+    Image frame;              // Mask from makePaddedMask with every pixel clear, for updateSeeds
+
+    // _________________________________________________________________________________________________________________
+    /// @brief Resets labels, costs, parents and the queue to the seeds-only state
+    void initialize()
+    {
+        int pixelCount = image.w * image.h;
+        labels.assign(pixelCount, -1);
+        costs.assign(pixelCount, std::numeric_limits<float>::infinity());
+        parent.assign(pixelCount, -1);
+        finalized = makePaddedMask(image.w, image.h);
+        queue.reset(pixelCount);
+        forestReady = false;
+        if ((int)markers.size() == pixelCount)
+        {
+            for (int pos = 0; pos < pixelCount; ++pos)
+            {
+                if (markers[pos] < 0)
+                    continue;
+                labels[pos] = markers[pos];
+                costs[pos] = 0.0f;
+                queue.pushOrDecrease(pos, 0.0f);
             }
         }
+        for (const auto &seed : seeds)
+        {
+            labels[seed.first] = seed.second;
+            costs[seed.first] = 0.0f; // Set initial cost for seed pixels
+            queue.pushOrDecrease(seed.first, 0.0f);
+        }
     }
 };
\ No newline at end of file
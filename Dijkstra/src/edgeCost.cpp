@@ -4,27 +4,35 @@
 #include <limits> // Required for std::numeric_limits
 #include <cmath>  // Required for sqrtf
 #include <vector>
+#include <typeinfo> // Required for typeid
 
 class EdgeCost
 {
 protected:
-    Image image;
+    ImageView image; // Not owned; the image must outlive the cost
 
 public:
-    EdgeCost(const Image &image) : image(image) {}
+    EdgeCost(ImageView image) : image(image) {}
     virtual float getCost(int from, int to) const = 0;
     virtual ~EdgeCost() = default;
+
+    ImageView getImage() const { return image; }
+
+    /// @brief Largest cost if every cost is a non-negative integer, -1 otherwise
+    /// @details CM uses a bucket queue instead of a heap when costs are integers with a small bound.
+    virtual int maxIntegerCost() const { return -1; }
+
+    /// @brief True if getCost(a, b) == getCost(b, a); CM can then precompute the weights (CM::edgeWeights)
+    virtual bool isSymmetric() const { return false; }
 };
 
 class EuclidianDistance_EdgeCost : public EdgeCost
 {
 public:
-    EuclidianDistance_EdgeCost(const Image &image) : EdgeCost(image) {}
+    EuclidianDistance_EdgeCost(ImageView image) : EdgeCost(image) {}
 
     float getCost(int from, int to) const override
     {
-        // Assuming the image data is in RGB format
-        uint8_t *data = image.data;
         int channels = image.channels;
 
         if (from < 0 || from >= image.w * image.h || to < 0 || to >= image.w * image.h)
@@ -32,23 +40,105 @@ public:
             return std::numeric_limits<float>::infinity(); // Return a large cost for invalid indices
         }
 
-        std::vector<int> fromCols(channels);
-        std::vector<int> toCols(channels);
+        const uint8_t *fromCols = image.pixel(from % image.w, from / image.w);
+        const uint8_t *toCols = image.pixel(to % image.w, to / image.w);
 
+        float distanceSquared = 0;
         for (int i = 0; i < channels; ++i)
         {
-            fromCols[i] = data[from * channels + i];
-            toCols[i] = data[to * channels + i];
+            float diff = fromCols[i] - toCols[i];
+            distanceSquared += diff * diff;
         }
 
+        // Calculate Euclidean distance in RGB space
+        return sqrtf(distanceSquared);
+    }
+
+    /// @brief On single-channel images (e.g. the gradient) the distance is |a - b|, an integer in [0, 255]
+    int maxIntegerCost() const override
+    {
+        return image.channels == 1 ? 255 : -1;
+    }
+
+    bool isSymmetric() const override { return true; }
+};
+
+// _____________________________________________________________________________________________________________________
+// Static cost policies: CM's relaxation loops are templated on these, so the cost of an edge inlines instead of going
+// through a virtual call. Indices are not checked; the loops only pass pixels of the image. The third argument is the
+// neighbor's index in the Neighborhood order, used by precomputed weights (weightPlanes.cpp). Policies whose
+// symmetric() is true satisfy cost(a, b) == cost(b, a) and may be precomputed.
+
+/// @brief Unit cost, used when CM has no edge cost function
+struct UnitCostPolicy
+{
+    bool symmetric() const { return true; }
+
+    float operator()(int, int, int = 0) const { return 1.0f; }
+};
+
+/// @brief EuclidianDistance_EdgeCost with the channel count fixed at compile time; same results bit for bit
+template <int Channels>
+struct EuclideanCostPolicy
+{
+    const uint8_t *data;
+
+    bool symmetric() const { return true; }
+
+    float operator()(int from, int to, int = 0) const
+    {
+        const uint8_t *fromCols = data + from * Channels;
+        const uint8_t *toCols = data + to * Channels;
+        if (Channels == 1)
+            return fabsf((float)(fromCols[0] - toCols[0])); // sqrtf(d * d) is exact for |d| <= 255
+
         float distanceSquared = 0;
-        for (int i = 0; i < channels; ++i)
+        for (int i = 0; i < Channels; ++i)
         {
             float diff = fromCols[i] - toCols[i];
             distanceSquared += diff * diff;
         }
-
-        // Calculate Euclidean distance in RGB space
         return sqrtf(distanceSquared);
     }
-};
\ No newline at end of file
+};
+
+/// @brief Fallback through the virtual interface, for any other EdgeCost (plugins)
+struct VirtualCostPolicy
+{
+    const EdgeCost *cost;
+
+    bool symmetric() const { return cost->isSymmetric(); }
+
+    float operator()(int from, int to, int = 0) const { return cost->getCost(from, to); }
+};
+
+// _____________________________________________________________________________________________________________________
+/// @brief Calls visit(policy) with the fastest static policy equivalent to 'cost' (nullptr means unit cost)
+/// @details Only an exact EuclidianDistance_EdgeCost over unpadded rows with 1, 3 or 4 channels is specialized;
+///          subclasses may override getCost, so they take the virtual fallback like any other EdgeCost.
+template <typename Visit>
+void visitCostPolicy(const EdgeCost *cost, Visit visit)
+{
+    if (!cost)
+    {
+        visit(UnitCostPolicy());
+        return;
+    }
+    if (typeid(*cost) == typeid(EuclidianDistance_EdgeCost) && cost->getImage().contiguous())
+    {
+        ImageView image = cost->getImage();
+        switch (image.channels)
+        {
+        case 1:
+            visit(EuclideanCostPolicy<1>{image.data});
+            return;
+        case 3:
+            visit(EuclideanCostPolicy<3>{image.data});
+            return;
+        case 4:
+            visit(EuclideanCostPolicy<4>{image.data});
+            return;
+        }
+    }
+    visit(VirtualCostPolicy{cost});
+}
@@ -1,56 +1,174 @@
 #include "image/image.cpp"
+#include "parallel.cpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 class gradient
 {
 public:
-    static int sumChannels(uint8_t *pixel, int channels)
+    static int sumChannels(const uint8_t *pixel, int channels)
     {
         int ret = 0;
-        for (size_t i = 0; i < channels; i++)
+        for (int i = 0; i < channels; i++)
         {
             ret += pixel[i];
         }
         return ret / channels;
     }
 
-    static Image generateGradient(Image image)
+    // _________________________________________________________________________________________________________________
+    /// @brief Sobel gradient magnitude of 'image' as an 8-bit single-channel image (magnitudes above 255 saturate)
+    static Image generateGradient(ImageView image)
+    {
+        Image result(image.w, image.h, 1);
+        sobel(image, result.data, result.stride);
+        return result;
+    }
+
+    /// @brief Sobel gradient magnitude without the 255 clamp (at most 1442), one value per pixel, row-major
+    static std::vector<uint16_t> generateGradient16(ImageView image)
+    {
+        std::vector<uint16_t> result((size_t)image.w * image.h);
+        sobel(image, result.data(), (size_t)image.w);
+        return result;
+    }
+
+    /// @brief Sobel gradient magnitude as float, not truncated to an integer, one value per pixel, row-major
+    static std::vector<float> generateGradientFloat(ImageView image)
+    {
+        std::vector<float> result((size_t)image.w * image.h);
+        sobel(image, result.data(), (size_t)image.w);
+        return result;
+    }
+
+    // _________________________________________________________________________________________________________________
+    /// @brief Sobel magnitude sqrt(gx^2 + gy^2) of the channel average of 'image' into 'out' (rows 'outStride' elements apart)
+    /// @details The channel average is computed once per pixel, then each row band runs the separable Sobel
+    ///          (smoothing [1 2 1] times difference [-1 0 1]) with SSE2 where available. Pixels outside the image
+    ///          repeat the nearest edge pixel, so border pixels get a real gradient instead of a fixed value.
+    ///          Integer outputs truncate the magnitude; uint8_t saturates at 255. Every output depends only on
+    ///          the input, whatever the thread count.
+    template <typename T>
+    static void sobel(ImageView image, T *out, size_t outStride)
+    {
+        int width = image.w, height = image.h;
+        if (width <= 0 || height <= 0)
+            return;
+
+        // Channel average, once per pixel
+        std::vector<uint8_t> intensity((size_t)width * height);
+        parallel::forRanges(0, height, [&](int fromRow, int toRow, int)
+                            {
+            for (int y = fromRow; y < toRow; ++y)
+            {
+                const uint8_t *pixel = image.row(y);
+                uint8_t *row = intensity.data() + (size_t)y * width;
+                if (image.channels == 1)
+                    memcpy(row, pixel, width);
+                else
+                    for (int x = 0; x < width; ++x, pixel += image.channels)
+                        row[x] = (uint8_t)sumChannels(pixel, image.channels);
+            } });
+
+        parallel::forRanges(0, height, [&](int fromRow, int toRow, int)
+                            {
+            // Column sums of the three rows, with one replicated column on each side
+            std::vector<int16_t> smooth(width + 2), diff(width + 2);
+            for (int y = fromRow; y < toRow; ++y)
+            {
+                const uint8_t *above = intensity.data() + (size_t)(y > 0 ? y - 1 : 0) * width;
+                const uint8_t *center = intensity.data() + (size_t)y * width;
+                const uint8_t *below = intensity.data() + (size_t)(y < height - 1 ? y + 1 : y) * width;
+                columnSums(above, center, below, smooth.data() + 1, diff.data() + 1, width);
+                smooth[0] = smooth[1];
+                diff[0] = diff[1];
+                smooth[width + 1] = smooth[width];
+                diff[width + 1] = diff[width];
+                magnitudeRow(smooth.data() + 1, diff.data() + 1, out + (size_t)y * outStride, width);
+            } });
+    }
+
+private:
+    // _________________________________________________________________________________________________________________
+    /// @brief smooth[x] = above + 2 center + below, diff[x] = below - above
+    static void columnSums(const uint8_t *above, const uint8_t *center, const uint8_t *below,
+                           int16_t *smooth, int16_t *diff, int width)
     {
-        // Sobel kernels
-        int gx[3][3] = {
-            {-1, 0, 1},
-            {-2, 0, 2},
-            {-1, 0, 1}};
-        int gy[3][3] = {
-            {-1, -2, -1},
-            {0, 0, 0},
-            {1, 2, 1}};
-
-        int width = image.w;
-        int height = image.h;
-        Image result(width, height, 1);
-
-        for (int y = 1; y < height - 1; ++y)
+        int x = 0;
+#ifdef __SSE2__
+        __m128i zero = _mm_setzero_si128();
+        for (; x + 16 <= width; x += 16)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i *)(above + x));
+            __m128i c = _mm_loadu_si128((const __m128i *)(center + x));
+            __m128i b = _mm_loadu_si128((const __m128i *)(below + x));
+            __m128i aLo = _mm_unpacklo_epi8(a, zero), aHi = _mm_unpackhi_epi8(a, zero);
+            __m128i cLo = _mm_unpacklo_epi8(c, zero), cHi = _mm_unpackhi_epi8(c, zero);
+            __m128i bLo = _mm_unpacklo_epi8(b, zero), bHi = _mm_unpackhi_epi8(b, zero);
+            _mm_storeu_si128((__m128i *)(smooth + x), _mm_add_epi16(_mm_add_epi16(aLo, bLo), _mm_add_epi16(cLo, cLo)));
+            _mm_storeu_si128((__m128i *)(smooth + x + 8), _mm_add_epi16(_mm_add_epi16(aHi, bHi), _mm_add_epi16(cHi, cHi)));
+            _mm_storeu_si128((__m128i *)(diff + x), _mm_sub_epi16(bLo, aLo));
+            _mm_storeu_si128((__m128i *)(diff + x + 8), _mm_sub_epi16(bHi, aHi));
+        }
+#endif
+        for (; x < width; ++x)
         {
-            for (int x = 1; x < width - 1; ++x)
+            smooth[x] = (int16_t)(above[x] + 2 * center[x] + below[x]);
+            diff[x] = (int16_t)(below[x] - above[x]);
+        }
+    }
+
+    // _________________________________________________________________________________________________________________
+    /// @brief out[x] = |(smooth[x + 1] - smooth[x - 1], diff[x - 1] + 2 diff[x] + diff[x + 1])|; index -1 and width must be readable
+    template <typename T>
+    static void magnitudeRow(const int16_t *smooth, const int16_t *diff, T *out, int width)
+    {
+        int x = 0;
+#ifdef __SSE2__
+        for (; x + 8 <= width; x += 8)
+        {
+            __m128i gx = _mm_sub_epi16(_mm_loadu_si128((const __m128i *)(smooth + x + 1)),
+                                       _mm_loadu_si128((const __m128i *)(smooth + x - 1)));
+            __m128i dc = _mm_loadu_si128((const __m128i *)(diff + x));
+            __m128i gy = _mm_add_epi16(_mm_add_epi16(_mm_loadu_si128((const __m128i *)(diff + x - 1)),
+                                                     _mm_loadu_si128((const __m128i *)(diff + x + 1))),
+                                       _mm_add_epi16(dc, dc));
+            // Interleave (gx, gy) pairs so madd yields gx^2 + gy^2 in 32 bits (at most 2 * 1020^2)
+            __m128i lo = _mm_unpacklo_epi16(gx, gy), hi = _mm_unpackhi_epi16(gx, gy);
+            __m128 magLo = _mm_sqrt_ps(_mm_cvtepi32_ps(_mm_madd_epi16(lo, lo)));
+            __m128 magHi = _mm_sqrt_ps(_mm_cvtepi32_ps(_mm_madd_epi16(hi, hi)));
+            if (std::is_same<T, float>::value)
             {
-                int sumX = 0;
-                int sumY = 0;
-                for (int ky = -1; ky <= 1; ++ky)
-                {
-                    for (int kx = -1; kx <= 1; ++kx)
-                    {
-                        uint8_t *pixel = image.getPixel(x + kx, y + ky);
-                        int pVal = sumChannels(pixel, image.channels);
-                        sumX += gx[ky + 1][kx + 1] * pVal;
-                        sumY += gy[ky + 1][kx + 1] * pVal;
-                    }
-                }
-                int magnitude = static_cast<int>(std::sqrt(sumX * sumX + sumY * sumY));
-                magnitude = std::min(255, std::max(0, magnitude));
-                uint8_t mag = (uint8_t)magnitude;
-                result.setPixel(x, y, &mag);
+                _mm_storeu_ps((float *)(out + x), magLo);
+                _mm_storeu_ps((float *)(out + x + 4), magHi);
+                continue;
             }
+            __m128i mag16 = _mm_packs_epi32(_mm_cvttps_epi32(magLo), _mm_cvttps_epi32(magHi)); // At most 1442
+            if (std::is_same<T, uint8_t>::value)
+                _mm_storel_epi64((__m128i *)(out + x), _mm_packus_epi16(mag16, mag16)); // Saturates at 255
+            else
+                _mm_storeu_si128((__m128i *)(out + x), mag16);
+        }
+#endif
+        for (; x < width; ++x)
+        {
+            int gx = smooth[x + 1] - smooth[x - 1];
+            int gy = diff[x - 1] + 2 * diff[x] + diff[x + 1];
+            float magnitude = sqrtf((float)(gx * gx + gy * gy));
+            if (std::is_same<T, float>::value)
+                out[x] = (T)magnitude;
+            else if (std::is_same<T, uint8_t>::value)
+                out[x] = (T)std::min(255, (int)magnitude);
+            else
+                out[x] = (T)(int)magnitude;
         }
-        return result;
     }
-};
\ No newline at end of file
+};
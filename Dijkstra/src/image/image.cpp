@@ -8,6 +8,13 @@
 
 #include "image.h"
 
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#ifdef _WIN32
+#include <malloc.h> // _aligned_malloc
+#endif
+
 Image::Image(const char *filename)
 {
     if (read(filename))
@@ -20,51 +27,147 @@ Image::Image(const char *filename)
     }
 }
 
-Image::Image(int w, int h, int channels)
-    : w(w), h(h), channels(channels)
+// _____________________________________________________________________________________________________________________
+/// @brief Allocates 'bytes' (rounded up to the alignment) at an Image::alignment boundary
+static uint8_t *alignedAlloc(size_t bytes)
+{
+    bytes = (bytes + Image::alignment - 1) / Image::alignment * Image::alignment;
+    if (bytes == 0)
+        return NULL;
+#ifdef _WIN32
+    return (uint8_t *)_aligned_malloc(bytes, Image::alignment);
+#else
+    return (uint8_t *)aligned_alloc(Image::alignment, bytes);
+#endif
+}
+
+static void alignedFree(uint8_t *pointer)
+{
+#ifdef _WIN32
+    _aligned_free(pointer);
+#else
+    free(pointer);
+#endif
+}
+
+Image::Image(int w, int h, int channels, int border, int rowAlignment)
 {
-    size = w * h * channels;
-    data = (uint8_t *)STBI_MALLOC(size);
+    size_t alignTo = rowAlignment > 1 ? (size_t)rowAlignment : 1;
+    size_t rowBytes = (size_t)(w + 2 * border) * channels;
+    allocate(w, h, channels, border, (rowBytes + alignTo - 1) / alignTo * alignTo);
 }
 
 Image::Image(const Image &other)
-    : Image(other.w, other.h, other.channels)
 {
-    if (other.data)
+    if (!other.data)
+        return;
+    allocate(other.w, other.h, other.channels, other.border, other.stride);
+    memcpy(buffer, other.buffer, stride * (h + 2 * border)); // Same layout: copy border and padding too
+}
+
+Image::Image(Image &&other) noexcept
+{
+    swap(other);
+}
+
+Image &Image::operator=(const Image &other)
+{
+    if (this != &other)
     {
-        memcpy(data, other.data, size);
+        Image copy(other);
+        swap(copy);
     }
-    else
+    return *this;
+}
+
+Image &Image::operator=(Image &&other) noexcept
+{
+    if (this != &other)
     {
-        data = NULL;
+        release();
+        swap(other);
     }
+    return *this;
 }
 
 Image::~Image()
 {
-    if (data)
+    release();
+}
+
+void Image::allocate(int w, int h, int channels, int border, size_t stride)
+{
+    release();
+    this->w = w;
+    this->h = h;
+    this->channels = channels;
+    this->border = border;
+    this->stride = stride;
+    buffer = alignedAlloc(stride * (h + 2 * border));
+    if (!buffer)
+        return;
+    data = buffer + border * stride + (size_t)border * channels;
+    size = stride * h;
+}
+
+void Image::release()
+{
+    alignedFree(buffer);
+    buffer = NULL;
+    data = NULL;
+    size = 0;
+}
+
+void Image::swap(Image &other) noexcept
+{
+    std::swap(buffer, other.buffer);
+    std::swap(data, other.data);
+    std::swap(size, other.size);
+    std::swap(w, other.w);
+    std::swap(h, other.h);
+    std::swap(channels, other.channels);
+    std::swap(stride, other.stride);
+    std::swap(border, other.border);
+}
+
+void Image::fillBorder(uint8_t value)
+{
+    if (!buffer)
+        return;
+    size_t rowBytes = (size_t)w * channels;
+    for (int y = -border; y < h + border; ++y)
     {
-        stbi_image_free(data);
-        data = NULL;
+        uint8_t *rowStart = buffer + (y + border) * stride;
+        if (y < 0 || y >= h)
+        {
+            memset(rowStart, value, stride);
+            continue;
+        }
+        uint8_t *first = data + y * stride;
+        memset(rowStart, value, first - rowStart);                       // Left border
+        memset(first + rowBytes, value, rowStart + stride - (first + rowBytes)); // Right border and padding
     }
 }
 
 bool Image::read(const char *filename)
 {
-    if (data)
-    {
-        STBI_FREE(data);
-        data = NULL;
-    }
+    release();
 
-    data = stbi_load(filename, &w, &h, &channels, 0);
-    if (!data)
+    // stb allocates with malloc; move the pixels into an aligned buffer
+    int width, height, fileChannels;
+    uint8_t *loaded = stbi_load(filename, &width, &height, &fileChannels, 0);
+    if (!loaded)
     {
         return false;
     }
 
-    size = w * h * channels;
-    return true;
+    allocate(width, height, fileChannels, 0, (size_t)width * fileChannels);
+    if (data)
+    {
+        memcpy(data, loaded, size);
+    }
+    stbi_image_free(loaded);
+    return data != NULL;
 }
 
 bool Image::write(const char *filename)
@@ -73,23 +176,38 @@ bool Image::write(const char *filename)
     {
         return false;
     }
+
+    // Only the PNG writer takes a stride; give the others unpadded rows
+    ImageFormat format = getFileFormat(filename);
+    const uint8_t *pixels = data;
+    Image packed;
+    if (format != FORMAT_PNG && !contiguous())
+    {
+        packed = Image(w, h, channels);
+        for (int y = 0; y < h; ++y)
+        {
+            memcpy(packed.data + (size_t)y * packed.stride, data + y * stride, (size_t)w * channels);
+        }
+        pixels = packed.data;
+    }
+
     int result = 0;
-    switch (getFileFormat(filename))
+    switch (format)
     {
     case FORMAT_PNG:
-        result = stbi_write_png(filename, w, h, channels, data, w * channels);
+        result = stbi_write_png(filename, w, h, channels, pixels, (int)stride);
         break;
     case FORMAT_BMP:
-        result = stbi_write_bmp(filename, w, h, channels, data);
+        result = stbi_write_bmp(filename, w, h, channels, pixels);
         break;
     case FORMAT_TGA:
-        result = stbi_write_tga(filename, w, h, channels, data);
+        result = stbi_write_tga(filename, w, h, channels, pixels);
         break;
     case FORMAT_JPG:
-        result = stbi_write_jpg(filename, w, h, channels, data, 100); // Default quality set to 100
+        result = stbi_write_jpg(filename, w, h, channels, pixels, 100); // Default quality set to 100
         break;
     case FORMAT_HDR:
-        result = stbi_write_hdr(filename, w, h, channels, (float *)data);
+        result = stbi_write_hdr(filename, w, h, channels, (const float *)pixels);
         break;
     default:
         printf("Unknown or unsuported image format for file: %s\n", filename);
@@ -134,15 +252,7 @@ uint8_t *Image::getPixel(int x, int y)
     {
         return nullptr;
     }
-
-    uint8_t *retData = (uint8_t *)malloc(channels * sizeof(uint8_t));
-    if (!retData)
-    {
-        return nullptr;
-    }
-
-    memcpy(retData, data + (y * w + x) * channels, channels);
-    return retData;
+    return data + y * stride + (size_t)x * channels;
 }
 
 void Image::setPixel(int x, int y, uint8_t *pixelData)
@@ -151,7 +261,7 @@ void Image::setPixel(int x, int y, uint8_t *pixelData)
     {
         return;
     }
-    uint8_t *dst = data + (y * w + x) * channels;
+    uint8_t *dst = data + y * stride + (size_t)x * channels;
     memcpy(dst, pixelData, channels);
 }
 
@@ -2,6 +2,7 @@
 #define IMAGE_H
 
 #include <stdint.h>
+#include <cstddef>
 #include <cstdio>
 
 enum ImageFormat
@@ -16,23 +17,75 @@ enum ImageFormat
 
 struct Image
 {
-    uint8_t *data = NULL; // Pointer to the image data
-    size_t size = 0;      // Size of the image data in bytes
-    int w;                // Width of the image in pixels
-    int h;                // Height of the image in pixels
-    int channels;         // Number of color channels in the image (e.g., 3 for RGB, 4 for RGBA)
+    static const size_t alignment = 64; // Byte alignment of every pixel buffer
 
+    uint8_t *data = NULL; // Pointer to the first pixel of the first row
+    size_t size = 0;      // Size of the image data in bytes (h * stride)
+    int w = 0;            // Width of the image in pixels
+    int h = 0;            // Height of the image in pixels
+    int channels = 0;     // Number of color channels in the image (e.g., 3 for RGB, 4 for RGBA)
+    size_t stride = 0;    // Bytes from the start of one row to the next (w * channels unless padded)
+    int border = 0;       // Pixels of margin allocated around the image on every side (see fillBorder)
+
+    Image() = default;
     Image(const char *filename);
-    Image(int w, int h, int channels);
+    /// @param border Extra pixels allocated on every side, e.g. 1 for a sentinel ring around the image
+    /// @param rowAlignment Rows start a multiple of this many bytes apart; 64 aligns every row for SIMD when border is 0
+    Image(int w, int h, int channels, int border = 0, int rowAlignment = 1);
     Image(const Image &other);
+    Image(Image &&other) noexcept;
+    Image &operator=(const Image &other);
+    Image &operator=(Image &&other) noexcept;
     ~Image();
 
     bool read(const char *filename);
     bool write(const char *filename);
 
+    /// @brief Frees the pixels; the image becomes empty
+    void release();
+
+    /// @brief Sets every byte of the border and of the row padding to 'value'
+    void fillBorder(uint8_t value);
+
+    /// @brief True if rows are not padded, so pixel y * w + x is at data + (y * w + x) * channels
+    bool contiguous() const { return stride == (size_t)w * channels; }
+
+    /// @brief The channels of pixel (x, y) in place (not a copy; do not free), or nullptr outside the image
     uint8_t *getPixel(int x, int y);
     void setPixel(int x, int y, uint8_t *data);
 
     ImageFormat getFileFormat(const char *filename);
+
+private:
+    uint8_t *buffer = NULL; // Start of the aligned allocation, border included
+
+    void allocate(int w, int h, int channels, int border, size_t stride);
+    void swap(Image &other) noexcept;
+};
+
+/// @brief Non-owning, read-only view of an image's pixels
+/// @details Cheap to copy and pass by value; it does not keep the pixels alive, so the viewed Image (or buffer)
+///          must outlive it. Rows are 'stride' bytes apart.
+struct ImageView
+{
+    const uint8_t *data = NULL; // First pixel of the first row
+    int w = 0;                  // Width of the image in pixels
+    int h = 0;                  // Height of the image in pixels
+    int channels = 0;           // Number of color channels per pixel
+    size_t stride = 0;          // Bytes from the start of one row to the next
+
+    ImageView() = default;
+    ImageView(const uint8_t *data, int w, int h, int channels)
+        : data(data), w(w), h(h), channels(channels), stride((size_t)w * channels) {}
+    ImageView(const uint8_t *data, int w, int h, int channels, size_t stride)
+        : data(data), w(w), h(h), channels(channels), stride(stride) {}
+    ImageView(const Image &image) // Implicit, so an Image can be passed wherever a view is expected
+        : ImageView(image.data, image.w, image.h, image.channels, image.stride) {}
+
+    const uint8_t *row(int y) const { return data + (size_t)y * stride; }
+    const uint8_t *pixel(int x, int y) const { return row(y) + (size_t)x * channels; }
+
+    /// @brief True if pixel index y * w + x is at byte (y * w + x) * channels, i.e. rows are not padded
+    bool contiguous() const { return stride == (size_t)w * channels; }
 };
 #endif // IMAGE_H
\ No newline at end of file
@@ -0,0 +1,126 @@
+#ifndef INDEXED_HEAP_CPP
+#define INDEXED_HEAP_CPP
+
+#include <vector>
+
+/// @brief Indexed D-ary min-heap over element ids [0, capacity) with float keys and decrease-key
+/// @details Every id is in the heap at most once, so its size is bounded by the capacity. Equal keys
+///          are ordered by id, which makes the pop order a total order independent of insertion history.
+template <int D = 4>
+class IndexedHeap
+{
+public:
+    // _________________________________________________________________________________________________________________
+    /// @brief Empties the heap and sizes it for ids in [0, capacity)
+    void reset(int capacity)
+    {
+        nodes.clear();
+        nodes.reserve(capacity);
+        position.assign(capacity, -1);
+    }
+
+    bool empty() const { return nodes.empty(); }
+    int size() const { return (int)nodes.size(); }
+    bool contains(int id) const { return position[id] >= 0; }
+    float topKey() const { return nodes.front().key; }
+
+    // _________________________________________________________________________________________________________________
+    /// @brief Inserts 'id' with 'key', or lowers its key if it is already queued with a larger one
+    void pushOrDecrease(int id, float key)
+    {
+        int at = position[id];
+        if (at < 0)
+        {
+            at = (int)nodes.size();
+            nodes.push_back(Node{key, id});
+            position[id] = at;
+        }
+        else if (!less(Node{key, id}, nodes[at]))
+        {
+            return; // Not an improvement
+        }
+        else
+        {
+            nodes[at].key = key;
+        }
+        siftUp(at);
+    }
+
+    // _________________________________________________________________________________________________________________
+    /// @brief Removes and returns the id with the smallest key
+    int pop()
+    {
+        int top = nodes.front().id;
+        position[top] = -1;
+        Node last = nodes.back();
+        nodes.pop_back();
+        if (!nodes.empty())
+        {
+            nodes[0] = last;
+            position[last.id] = 0;
+            siftDown(0);
+        }
+        return top;
+    }
+
+private:
+    struct Node
+    {
+        float key;
+        int id;
+    };
+
+    std::vector<Node> nodes;   // Heap-ordered entries
+    std::vector<int> position; // Index of each id in 'nodes', -1 if not queued
+
+    static bool less(const Node &a, const Node &b)
+    {
+        return a.key < b.key || (a.key == b.key && a.id < b.id);
+    }
+
+    void place(int at, const Node &node)
+    {
+        nodes[at] = node;
+        position[node.id] = at;
+    }
+
+    void siftUp(int at)
+    {
+        Node node = nodes[at];
+        while (at > 0)
+        {
+            int parent = (at - 1) / D;
+            if (!less(node, nodes[parent]))
+                break;
+            place(at, nodes[parent]);
+            at = parent;
+        }
+        place(at, node);
+    }
+
+    void siftDown(int at)
+    {
+        Node node = nodes[at];
+        int count = (int)nodes.size();
+        while (true)
+        {
+            int first = at * D + 1;
+            if (first >= count)
+                break;
+            int best = first;
+            int end = first + D < count ? first + D : count;
+            for (int child = first + 1; child < end; ++child)
+            {
+                if (less(nodes[child], nodes[best]))
+                    best = child;
+            }
+            if (!less(nodes[best], node))
+                break;
+            place(at, nodes[best]);
+            at = best;
+        }
+        place(at, node);
+    }
+};
+
+#endif
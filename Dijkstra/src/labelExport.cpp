@@ -0,0 +1,139 @@
+#ifndef LABEL_EXPORT_CPP
+#define LABEL_EXPORT_CPP
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/// @brief Writes label maps (e.g. CM::labels) straight to disk, without the colour step
+class labelExport
+{
+public:
+    // _________________________________________________________________________________________________________________
+    /// @brief Writes the labels as a NumPy .npy array (version 1.0) of shape (height, width), little-endian
+    /// @details With useUint16 the unlabeled value -1 is written as 0 (seed labels start at 1) and the
+    ///          call fails if any label does not fit in 16 bits; otherwise the labels are written as int32.
+    static bool writeNpy(const std::vector<int> &labels, int width, int height, const char *filename, bool useUint16 = false)
+    {
+        size_t totalPixels = (size_t)width * height;
+        if (labels.size() != totalPixels)
+        {
+            printf("Label map size does not match %dx%d\n", width, height);
+            return false;
+        }
+
+        if (useUint16)
+        {
+            for (int label : labels)
+            {
+                if (label < -1 || label > 0xFFFF)
+                {
+                    printf("Label %d does not fit in a uint16 label map\n", label);
+                    return false;
+                }
+            }
+        }
+
+        // Header dictionary, padded with spaces so the data starts on a 64-byte boundary
+        std::string header = std::string("{'descr': '") + (useUint16 ? "<u2" : "<i4") +
+                             "', 'fortran_order': False, 'shape': (" + std::to_string(height) + ", " +
+                             std::to_string(width) + "), }";
+        size_t preamble = 10; // magic (6) + version (2) + header length (2)
+        size_t padded = ((preamble + header.size() + 1 + 63) / 64) * 64;
+        header.append(padded - preamble - header.size() - 1, ' ');
+        header.push_back('\n');
+
+        FILE *file = fopen(filename, "wb");
+        if (!file)
+        {
+            printf("Failed to open label map file: %s\n", filename);
+            return false;
+        }
+
+        std::vector<uint8_t> buffer = {0x93, 'N', 'U', 'M', 'P', 'Y', 1, 0};
+        putLittleEndian(buffer, header.size(), 2);
+        buffer.insert(buffer.end(), header.begin(), header.end());
+        fwrite(buffer.data(), 1, buffer.size(), file);
+
+        // Data, written one row at a time
+        int bytes = useUint16 ? 2 : 4;
+        for (int y = 0; y < height; ++y)
+        {
+            buffer.clear();
+            for (int x = 0; x < width; ++x)
+            {
+                int label = labels[(size_t)y * width + x];
+                if (useUint16 && label == -1)
+                {
+                    label = 0;
+                }
+                putLittleEndian(buffer, (uint32_t)label, bytes);
+            }
+            fwrite(buffer.data(), 1, buffer.size(), file);
+        }
+
+        bool ok = !ferror(file);
+        fclose(file);
+        return ok;
+    }
+
+    // _________________________________________________________________________________________________________________
+    /// @brief Writes the labels run-length encoded in row-major order (runs may cross rows)
+    /// @details Layout, all little-endian: "LRLE" | uint32 version (1) | uint32 width | uint32 height |
+    ///          uint64 runCount | runCount x (int32 label, uint32 length)
+    static bool writeRLE(const std::vector<int> &labels, int width, int height, const char *filename)
+    {
+        size_t totalPixels = (size_t)width * height;
+        if (labels.size() != totalPixels)
+        {
+            printf("Label map size does not match %dx%d\n", width, height);
+            return false;
+        }
+
+        std::vector<uint8_t> runs;
+        uint64_t runCount = 0;
+        size_t i = 0;
+        while (i < totalPixels)
+        {
+            size_t start = i;
+            while (i < totalPixels && labels[i] == labels[start] && i - start < 0xFFFFFFFFu)
+            {
+                ++i;
+            }
+            putLittleEndian(runs, (uint32_t)labels[start], 4);
+            putLittleEndian(runs, i - start, 4);
+            ++runCount;
+        }
+
+        std::vector<uint8_t> header = {'L', 'R', 'L', 'E'};
+        putLittleEndian(header, 1, 4);
+        putLittleEndian(header, width, 4);
+        putLittleEndian(header, height, 4);
+        putLittleEndian(header, runCount, 8);
+
+        FILE *file = fopen(filename, "wb");
+        if (!file)
+        {
+            printf("Failed to open label map file: %s\n", filename);
+            return false;
+        }
+        fwrite(header.data(), 1, header.size(), file);
+        fwrite(runs.data(), 1, runs.size(), file);
+        bool ok = !ferror(file);
+        fclose(file);
+        return ok;
+    }
+
+private:
+    // Appends 'value' as 'bytes' little-endian bytes, independent of host byte order
+    static void putLittleEndian(std::vector<uint8_t> &out, uint64_t value, int bytes)
+    {
+        for (int i = 0; i < bytes; ++i)
+        {
+            out.push_back((uint8_t)((value >> (8 * i)) & 0xFF));
+        }
+    }
+};
+
+#endif
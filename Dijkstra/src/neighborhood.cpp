@@ -0,0 +1,86 @@
+#ifndef NEIGHBORHOOD_CPP
+#define NEIGHBORHOOD_CPP
+
+#include "image/image.cpp"
+
+#include <cstdint>
+#include <cstring>
+
+// _____________________________________________________________________________________________________________________
+/// @brief Mask over a width x height image with a 1-pixel sentinel border (Image::border = 1): 1 on the border, 0 inside
+/// @details A neighbor outside the image then reads as a set (blocked) cell, so no pixel needs a bounds check.
+///          The mask rows are not padded beyond the border, so its stride is width + 2.
+inline Image makePaddedMask(int width, int height)
+{
+    Image mask(width, height, 1, 1);
+    mask.fillBorder(1);
+    for (int y = 0; y < height; y++)
+        memset(mask.data + y * mask.stride, 0, width);
+    return mask;
+}
+
+/// @brief Index of pixel 'pos' from mask.data in any mask made by makePaddedMask for a width-wide image
+/// @details With the stride at width + 2, row y is shifted by 2 * y, so one division is enough. Hot loops compute
+///          it once per popped pixel and get the neighbors' indices from forEachOpen.
+inline int maskIndex(int pos, int width)
+{
+    return pos + (pos / width) * 2;
+}
+
+/// @brief Cell of pixel 'pos' in a mask made by makePaddedMask
+inline uint8_t *maskCell(const Image &mask, int pos)
+{
+    return mask.data + maskIndex(pos, mask.w);
+}
+
+// _____________________________________________________________________________________________________________________
+/// @brief 4- or 8-neighborhood of a row-major image as precomputed offset tables
+/// @details Neighbors are visited in a fixed order: up, (up-left, up-right,) left, right, down, (down-left, down-right).
+template <bool Diagonal>
+class Neighborhood
+{
+public:
+    static constexpr int count = Diagonal ? 8 : 4;
+
+    int width;
+    int dx[count], dy[count]; // Neighbor displacements, in visiting order
+    int pixelOffset[count];   // Neighbor offsets in the image
+    int paddedOffset[count];  // The same offsets in a mask from makePaddedMask (and between maskIndex values)
+
+    explicit Neighborhood(int width) : width(width)
+    {
+        static const int dx8[8] = {0, -1, 1, -1, 1, 0, -1, 1};
+        static const int dy8[8] = {-1, -1, -1, 0, 0, 1, 1, 1};
+        static const int dx4[4] = {0, -1, 1, 0};
+        static const int dy4[4] = {-1, 0, 0, 1};
+        for (int k = 0; k < count; k++)
+        {
+            dx[k] = Diagonal ? dx8[k] : dx4[k];
+            dy[k] = Diagonal ? dy8[k] : dy4[k];
+            pixelOffset[k] = dy[k] * width + dx[k];
+            paddedOffset[k] = dy[k] * (width + 2) + dx[k];
+        }
+    }
+
+    // _________________________________________________________________________________________________________________
+    /// @brief Calls visit(neighbor, k) for every neighbor of pixel 'pos' whose cell in 'mask' (see makePaddedMask)
+    ///        is clear; k is the neighbor's index in the visiting order
+    template <typename Visit>
+    void forEachOpen(int pos, const Image &mask, Visit visit) const
+    {
+        forEachOpen(pos, maskIndex(pos, width), mask, [&](int neighbor, int k, int) { visit(neighbor, k); });
+    }
+
+    /// @brief Same, for a pixel whose maskIndex is already known; calls visit(neighbor, k, neighborIndex), where
+    ///        neighborIndex is the neighbor's maskIndex (valid in every mask of this size)
+    template <typename Visit>
+    void forEachOpen(int pos, int index, const Image &mask, Visit visit) const
+    {
+        const uint8_t *cell = mask.data + index;
+        for (int k = 0; k < count; k++)
+            if (!cell[paddedOffset[k]])
+                visit(pos + pixelOffset[k], k, index + paddedOffset[k]);
+    }
+};
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef PARALLEL_CPP
+#define PARALLEL_CPP
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+/// @brief Minimal fork-join helper used by the data-parallel passes
+class parallel
+{
+public:
+    // _________________________________________________________________________________________________________________
+    /// @brief Number of worker threads used by forRanges (0 = std::thread::hardware_concurrency)
+    static int threadCount()
+    {
+        if (requestedThreads > 0)
+            return requestedThreads;
+        int hw = (int)std::thread::hardware_concurrency();
+        return hw > 0 ? hw : 1;
+    }
+
+    static void setThreadCount(int threads)
+    {
+        requestedThreads = threads;
+    }
+
+    // _________________________________________________________________________________________________________________
+    /// @brief Splits [begin, end) into one contiguous range per worker and runs fn(from, to, worker) on each
+    /// @details Ranges are assigned in order, so worker w always gets the w-th slice; results merged
+    ///          by worker index are therefore reproducible for a given thread count.
+    template <typename Fn>
+    static void forRanges(int begin, int end, Fn fn, int workers = 0)
+    {
+        if (workers <= 0)
+            workers = threadCount();
+        workers = std::max(1, std::min(workers, end - begin));
+
+        if (workers == 1)
+        {
+            fn(begin, end, 0);
+            return;
+        }
+
+        std::vector<std::thread> threads;
+        threads.reserve(workers - 1);
+        int span = end - begin;
+        for (int w = 1; w < workers; ++w)
+        {
+            int from = begin + (int)((long long)span * w / workers);
+            int to = begin + (int)((long long)span * (w + 1) / workers);
+            threads.emplace_back(fn, from, to, w);
+        }
+        fn(begin, begin + (int)((long long)span / workers), 0);
+
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+private:
+    inline static int requestedThreads = 0;
+};
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef PATH_COST_CPP
+#define PATH_COST_CPP
+
+/// @brief Path-cost function of CM: the cost of a path extended by one arc
+enum class PathCost
+{
+    Sum, // fsum: sum of the arc weights (geodesic distance)
+    Max  // fmax: largest arc weight on the path (watershed by flooding); never above the largest arc weight
+};
+
+// _____________________________________________________________________________________________________________________
+/// @brief Static policies for PathCost, used by the CM queue loops: extend(path, arc) is the cost of a path of cost
+///        'path' extended by an arc of weight 'arc'. Both are non-decreasing, so every monotone queue stays valid.
+struct SumPathCost
+{
+    template <typename T>
+    static T extend(T path, T arc) { return path + arc; }
+};
+
+struct MaxPathCost
+{
+    template <typename T>
+    static T extend(T path, T arc) { return path < arc ? arc : path; }
+};
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef RADIX_HEAP_CPP
+#define RADIX_HEAP_CPP
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/// @brief Monotone radix heap over (id, float key) entries
+/// @details Keys below the last popped key must not be pushed. Floats are mapped to unsigned integers with the
+///          same order, and entries are kept in 33 buckets by the highest bit in which their key differs from the
+///          last popped key. A pop only redistributes the first non-empty bucket, so each entry moves at most 32
+///          times. Lowering a key means pushing the id again.
+class RadixHeap
+{
+public:
+    // _________________________________________________________________________________________________________________
+    /// @brief Empties the heap; 'expected' entries are reserved in the first bucket
+    void reset(int expected = 0)
+    {
+        for (auto &bucket : buckets)
+            bucket.clear();
+        buckets[0].reserve(expected);
+        last = 0;
+        count = 0;
+    }
+
+    bool empty() const { return count == 0; }
+    int size() const { return count; }
+
+    // _________________________________________________________________________________________________________________
+    /// @brief Inserts 'id' with 'key'; 'key' must not be smaller than the last popped key
+    void push(int id, float key)
+    {
+        uint32_t ordered = toOrdered(key);
+        buckets[bucketOf(ordered)].push_back(Entry{ordered, id});
+        count++;
+    }
+
+    // _________________________________________________________________________________________________________________
+    /// @brief Removes and returns an id with the smallest key, which is stored in 'key'
+    int pop(float &key)
+    {
+        if (buckets[0].empty())
+        {
+            int first = 1;
+            while (buckets[first].empty())
+                first++;
+
+            // The new minimum becomes the reference; every entry of this bucket lands in a lower one
+            std::vector<Entry> &moving = buckets[first];
+            last = moving[0].key;
+            for (const Entry &entry : moving)
+                if (entry.key < last)
+                    last = entry.key;
+            for (const Entry &entry : moving)
+                buckets[bucketOf(entry.key)].push_back(entry);
+            moving.clear();
+        }
+
+        Entry entry = buckets[0].back();
+        buckets[0].pop_back();
+        count--;
+        key = fromOrdered(entry.key);
+        return entry.id;
+    }
+
+private:
+    struct Entry
+    {
+        uint32_t key; // Ordered image of the float key
+        int id;
+    };
+
+    std::vector<Entry> buckets[33]; // Bucket b > 0 holds keys whose highest bit differing from 'last' is b - 1
+    uint32_t last = 0;              // Last popped key, ordered
+    int count = 0;
+
+    int bucketOf(uint32_t key) const
+    {
+        uint32_t diff = key ^ last;
+#if defined(__GNUC__)
+        return diff ? 32 - __builtin_clz(diff) : 0;
+#else
+        int bucket = 0;
+        for (; diff; diff >>= 1)
+            bucket++;
+        return bucket;
+#endif
+    }
+
+    /// @brief Maps floats to unsigned integers with the same order (negative values reverse their bits)
+    static uint32_t toOrdered(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+    }
+
+    static float fromOrdered(uint32_t ordered)
+    {
+        uint32_t bits = (ordered & 0x80000000u) ? (ordered & 0x7FFFFFFFu) : ~ordered;
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+};
+
+#endif
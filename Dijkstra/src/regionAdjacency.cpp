@@ -0,0 +1,194 @@
+#ifndef REGION_ADJACENCY_CPP
+#define REGION_ADJACENCY_CPP
+
+#include "parallel.cpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+/// @brief Region adjacency graph of a label map in compressed sparse row (CSR) form
+/// @details Region ids are 0..regionCount()-1; the neighbours of region r are
+///          neighbors[offsets[r] .. offsets[r + 1]), sorted by id, with one entry per direction.
+struct RegionGraph
+{
+    std::vector<int> regionLabel;    // Label value of each region id
+    std::vector<int> offsets;        // Row offsets, size regionCount() + 1
+    std::vector<int> neighbors;      // Neighbouring region id of each entry
+    std::vector<int> boundaryLength; // Number of 4-adjacent pixel pairs shared with that neighbour
+    std::vector<float> meanWeight;   // Mean edge cost across those pixel pairs
+
+    int regionCount() const { return (int)regionLabel.size(); }
+};
+
+class regionAdjacency
+{
+public:
+    // _________________________________________________________________________________________________________________
+    /// @brief Builds the adjacency graph of 'labels' with one parallel scan over horizontal and vertical pixel pairs
+    /// @param edgeWeight Weight of the pair (from, to), called inline; CM passes its static cost policy
+    /// @details Unlabeled pixels (-1) are not regions and contribute no edges.
+    template <typename EdgeWeight>
+    static RegionGraph build(const std::vector<int> &labels, int width, int height, const EdgeWeight &edgeWeight)
+    {
+        RegionGraph graph;
+
+        // Map label values to dense region ids, in increasing label order
+        int maxLabel = -1;
+        for (int label : labels)
+            maxLabel = std::max(maxLabel, label);
+        std::vector<int> regionOfLabel(maxLabel + 1, -1);
+        for (int label : labels)
+        {
+            if (label >= 0)
+                regionOfLabel[label] = 0;
+        }
+        for (int label = 0; label <= maxLabel; ++label)
+        {
+            if (regionOfLabel[label] == 0)
+            {
+                regionOfLabel[label] = graph.regionCount();
+                graph.regionLabel.push_back(label);
+            }
+        }
+
+        // - - - - - - - - - - - - - - - - - - - - - - - -
+        // Boundary pairs per row band, reduced by key in each worker (weights in fixed point, see PairEntry)
+        std::vector<std::vector<PairEntry>> partials(parallel::threadCount());
+        parallel::forRanges(0, height, [&](int fromRow, int toRow, int worker)
+                            {
+            std::vector<PairEntry> &local = partials[worker];
+            auto addPair = [&](int from, int to)
+            {
+                if (labels[from] == labels[to] || labels[from] < 0 || labels[to] < 0)
+                    return;
+                uint32_t a = (uint32_t)regionOfLabel[labels[from]];
+                uint32_t b = (uint32_t)regionOfLabel[labels[to]];
+                uint64_t key = a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+                local.push_back(PairEntry{key, 1, std::llround(edgeWeight(from, to) * weightScale)});
+            };
+
+            for (int y = fromRow; y < toRow; ++y)
+            {
+                for (int x = 0; x < width; ++x)
+                {
+                    int pos = y * width + x;
+                    if (x + 1 < width)
+                        addPair(pos, pos + 1);
+                    if (y + 1 < height)
+                        addPair(pos, pos + width);
+                }
+            }
+            reduce(local); }, (int)partials.size());
+
+        // Merge the per-worker lists into one list of undirected region pairs
+        std::vector<PairEntry> pairs;
+        for (std::vector<PairEntry> &partial : partials)
+        {
+            pairs.insert(pairs.end(), partial.begin(), partial.end());
+            std::vector<PairEntry>().swap(partial);
+        }
+        reduce(pairs);
+
+        // - - - - - - - - - - - - - - - - - - - - - - - -
+        // Symmetric CSR; pairs are sorted by (smaller, larger) id, so every row ends up sorted
+        int regions = graph.regionCount();
+        graph.offsets.assign(regions + 1, 0);
+        for (const PairEntry &pair : pairs)
+        {
+            graph.offsets[(pair.key >> 32) + 1]++;
+            graph.offsets[(pair.key & 0xFFFFFFFFu) + 1]++;
+        }
+        for (int r = 0; r < regions; ++r)
+            graph.offsets[r + 1] += graph.offsets[r];
+
+        size_t entries = graph.offsets[regions];
+        graph.neighbors.resize(entries);
+        graph.boundaryLength.resize(entries);
+        graph.meanWeight.resize(entries);
+        std::vector<int> fill(graph.offsets.begin(), graph.offsets.end() - 1);
+        for (const PairEntry &pair : pairs)
+        {
+            int a = (int)(pair.key >> 32);
+            int b = (int)(pair.key & 0xFFFFFFFFu);
+            float mean = (float)(pair.weightSum / weightScale / pair.count);
+
+            int slotA = fill[a]++;
+            graph.neighbors[slotA] = b;
+            graph.boundaryLength[slotA] = pair.count;
+            graph.meanWeight[slotA] = mean;
+
+            int slotB = fill[b]++;
+            graph.neighbors[slotB] = a;
+            graph.boundaryLength[slotB] = pair.count;
+            graph.meanWeight[slotB] = mean;
+        }
+
+        return graph;
+    }
+
+    // _________________________________________________________________________________________________________________
+    /// @brief Writes each undirected edge once as CSV: label_a,label_b,boundary_length,mean_weight
+    static bool writeCSV(const RegionGraph &graph, const char *filename)
+    {
+        FILE *file = fopen(filename, "w");
+        if (!file)
+        {
+            printf("Failed to open adjacency file: %s\n", filename);
+            return false;
+        }
+
+        fprintf(file, "label_a,label_b,boundary_length,mean_weight\n");
+        for (int r = 0; r < graph.regionCount(); ++r)
+        {
+            for (int e = graph.offsets[r]; e < graph.offsets[r + 1]; ++e)
+            {
+                if (graph.neighbors[e] > r)
+                {
+                    fprintf(file, "%d,%d,%d,%g\n", graph.regionLabel[r], graph.regionLabel[graph.neighbors[e]],
+                            graph.boundaryLength[e], graph.meanWeight[e]);
+                }
+            }
+        }
+
+        bool ok = !ferror(file);
+        fclose(file);
+        return ok;
+    }
+
+private:
+    struct PairEntry
+    {
+        uint64_t key; // (smaller region id << 32) | larger region id
+        int count;
+        int64_t weightSum; // Fixed point (weightScale units): integer sums do not depend on the reduction order
+    };
+
+    static constexpr double weightScale = 1 << 20;
+
+    // Sorts entries by key and merges equal keys in place
+    static void reduce(std::vector<PairEntry> &entries)
+    {
+        std::sort(entries.begin(), entries.end(), [](const PairEntry &a, const PairEntry &b)
+                  { return a.key < b.key; });
+
+        size_t out = 0;
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            if (out > 0 && entries[out - 1].key == entries[i].key)
+            {
+                entries[out - 1].count += entries[i].count;
+                entries[out - 1].weightSum += entries[i].weightSum;
+            }
+            else
+            {
+                entries[out++] = entries[i];
+            }
+        }
+        entries.resize(out);
+    }
+};
+
+#endif
@@ -0,0 +1,201 @@
+#ifndef REGIONAL_MINIMA_CPP
+#define REGIONAL_MINIMA_CPP
+
+#include "image/image.cpp"
+#include "parallel.cpp"
+#include "bucketQueue.cpp"
+#include "neighborhood.cpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/// @brief Automatic seeds: the regional minima of a gradient, for CM without hand-placed seeds
+class regionalMinima
+{
+public:
+    // _________________________________________________________________________________________________________________
+    /// @brief Labels the regional minima of an 8-bit image (e.g. gradient::generateGradient); only channel 0 is read
+    /// @details A regional minimum is a connected plateau with no lower neighbor. With depth > 0 the image is first
+    ///          raised to its h-minima transform (reconstruction by erosion of image + depth, one 256-level bucket
+    ///          flood), so only minima at least 'depth' deep are kept. Plateaus are then joined by union-find in
+    ///          parallel row bands and merged across the band seams. Labels do not depend on the thread count.
+    /// @param count Receives the number of minima if not null
+    /// @return Markers for CM, row-major: 1, 2, ... on the minima in raster order of their first pixel, -1 elsewhere
+    static std::vector<int> markers(ImageView image, int depth = 0, bool useDiagonal = true, int *count = nullptr)
+    {
+        int width = image.w, height = image.h;
+        std::vector<uint8_t> level((size_t)width * height);
+        parallel::forRanges(0, height, [&](int fromRow, int toRow, int)
+                            {
+            for (int y = fromRow; y < toRow; ++y)
+            {
+                const uint8_t *pixel = image.row(y);
+                uint8_t *row = level.data() + (size_t)y * width;
+                for (int x = 0; x < width; ++x, pixel += image.channels)
+                    row[x] = *pixel;
+            } });
+
+        if (depth > 0)
+        {
+            if (useDiagonal)
+                fill<true>(level, width, height, depth);
+            else
+                fill<false>(level, width, height, depth);
+        }
+        return useDiagonal ? label<true>(level, width, height, count) : label<false>(level, width, height, count);
+    }
+
+private:
+    // _________________________________________________________________________________________________________________
+    /// @brief Replaces 'level' by its h-minima transform: the lowest flooding from level + depth that stays above level
+    /// @details Every pixel starts at level + depth (saturated at 255) and is lowered to max(neighbor, own level) in
+    ///          increasing order, as an fmax IFT on a 256-level bucket queue. Linear in the pixel count.
+    template <bool Diagonal>
+    static void fill(std::vector<uint8_t> &level, int width, int height, int depth)
+    {
+        const Neighborhood<Diagonal> neighborhood(width);
+        std::vector<uint8_t> filled(level.size());
+        BucketQueue queue;
+        queue.reset(255);
+        for (size_t pos = 0; pos < level.size(); pos++)
+        {
+            filled[pos] = (uint8_t)std::min(255, level[pos] + depth);
+            queue.push((int)pos, filled[pos]);
+        }
+
+        Image done = makePaddedMask(width, height);
+        while (!queue.empty())
+        {
+            uint32_t key;
+            int current = queue.pop(key);
+            int index = maskIndex(current, width);
+            if (done.data[index])
+                continue; // Stale entry, the pixel was lowered further
+            done.data[index] = 1;
+            neighborhood.forEachOpen(current, index, done, [&](int neighbor, int, int)
+            {
+                uint8_t value = std::max(filled[current], level[neighbor]);
+                if (value < filled[neighbor])
+                {
+                    filled[neighbor] = value;
+                    queue.push(neighbor, value);
+                }
+            });
+        }
+        level.swap(filled);
+    }
+
+    // _________________________________________________________________________________________________________________
+    /// @brief Labels the plateaus of 'level' without a lower neighbor
+    template <bool Diagonal>
+    static std::vector<int> label(const std::vector<uint8_t> &level, int width, int height, int *count)
+    {
+        const Neighborhood<Diagonal> neighborhood(width);
+        const int pixelCount = width * height;
+        std::vector<int> root(pixelCount);        // Union-find forest of the plateaus; each root is its smallest pixel
+        std::vector<uint8_t> hasLower(pixelCount); // 1 if a neighbor is lower; moved to the roots below
+        std::vector<int> bandStart(parallel::threadCount(), -1);
+
+        // - - - - - - - - - - - - - - - - - - - - - - - -
+        // Plateaus within each row band: links only to the earlier neighbors of the same band
+        parallel::forRanges(0, height, [&](int fromRow, int toRow, int worker)
+                            {
+            bandStart[worker] = fromRow;
+            for (int y = fromRow; y < toRow; ++y)
+            {
+                for (int x = 0; x < width; ++x)
+                {
+                    int pos = y * width + x;
+                    root[pos] = pos;
+                    uint8_t value = level[pos];
+                    uint8_t lower = 0;
+                    for (int k = 0; k < neighborhood.count; k++)
+                    {
+                        int nx = x + neighborhood.dx[k], ny = y + neighborhood.dy[k];
+                        if (nx < 0 || nx >= width || ny < 0 || ny >= height)
+                            continue;
+                        int neighbor = pos + neighborhood.pixelOffset[k];
+                        lower |= level[neighbor] < value;
+                        bool earlier = ny < y ? ny >= fromRow : nx < x && ny == y;
+                        if (earlier && level[neighbor] == value)
+                            unite(root, pos, neighbor);
+                    }
+                    hasLower[pos] = lower;
+                }
+            } }, (int)bandStart.size());
+
+        // - - - - - - - - - - - - - - - - - - - - - - - -
+        // Plateaus crossing a band seam
+        for (int y : bandStart)
+        {
+            if (y <= 0)
+                continue;
+            for (int x = 0; x < width; ++x)
+            {
+                int pos = y * width + x;
+                for (int k = 0; k < neighborhood.count && neighborhood.dy[k] < 0; k++)
+                {
+                    int nx = x + neighborhood.dx[k];
+                    if (nx >= 0 && nx < width && level[pos + neighborhood.pixelOffset[k]] == level[pos])
+                        unite(root, pos, pos + neighborhood.pixelOffset[k]);
+                }
+            }
+        }
+
+        // - - - - - - - - - - - - - - - - - - - - - - - -
+        // Plateau of every pixel (the forest is only read from here on)
+        std::vector<int> markers(pixelCount);
+        parallel::forRanges(0, pixelCount, [&](int from, int to, int)
+                            {
+            for (int pos = from; pos < to; ++pos)
+            {
+                int top = pos;
+                while (root[top] != top)
+                    top = root[top];
+                markers[pos] = top;
+            } });
+
+        // A plateau with any lower neighbor is not a minimum; minima are numbered in raster order of their roots
+        for (int pos = 0; pos < pixelCount; ++pos)
+            if (hasLower[pos])
+                hasLower[markers[pos]] = 1;
+        int minima = 0;
+        for (int pos = 0; pos < pixelCount; ++pos)
+            if (markers[pos] == pos)
+                root[pos] = hasLower[pos] ? -1 : ++minima; // Roots are not read as links any more
+
+        parallel::forRanges(0, pixelCount, [&](int from, int to, int)
+                            {
+            for (int pos = from; pos < to; ++pos)
+                markers[pos] = root[markers[pos]]; });
+
+        if (count)
+            *count = minima;
+        return markers;
+    }
+
+    // _________________________________________________________________________________________________________________
+    /// @brief Joins the sets of 'a' and 'b'; the smaller root becomes the root, path halving on the way up
+    static void unite(std::vector<int> &root, int a, int b)
+    {
+        a = find(root, a);
+        b = find(root, b);
+        if (a < b)
+            root[b] = a;
+        else if (b < a)
+            root[a] = b;
+    }
+
+    static int find(std::vector<int> &root, int pos)
+    {
+        while (root[pos] != pos)
+        {
+            root[pos] = root[root[pos]];
+            pos = root[pos];
+        }
+        return pos;
+    }
+};
+
+#endif
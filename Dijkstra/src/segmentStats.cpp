@@ -0,0 +1,209 @@
+#ifndef SEGMENT_STATS_CPP
+#define SEGMENT_STATS_CPP
+
+#include "image/image.cpp"
+#include "parallel.cpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+/// @brief Summary of one segment of a label map
+struct SegmentStat
+{
+    int label;                 // Label value (seed label)
+    int area;                  // Number of pixels
+    int minX, minY, maxX, maxY; // Bounding box (inclusive)
+    double centroidX, centroidY;
+    std::vector<double> meanColor; // One mean per image channel
+};
+
+class segmentStats
+{
+public:
+    // _________________________________________________________________________________________________________________
+    /// @brief Computes area, bounding box, centroid and mean colour per label in one parallel pass
+    /// @details Each worker accumulates partial sums over a band of rows; partials are merged in worker
+    ///          order. Unlabeled pixels (-1) are skipped. Rows are sorted by label.
+    static std::vector<SegmentStat> compute(const std::vector<int> &labels, ImageView image)
+    {
+        int channels = image.channels;
+        std::vector<std::unordered_map<int, Accumulator>> partials(parallel::threadCount());
+
+        parallel::forRanges(0, image.h, [&](int fromRow, int toRow, int worker)
+                            {
+            std::unordered_map<int, Accumulator> &local = partials[worker];
+            Accumulator *acc = nullptr;
+            int accLabel = -1;
+            for (int y = fromRow; y < toRow; ++y)
+            {
+                for (int x = 0; x < image.w; ++x)
+                {
+                    int pos = y * image.w + x;
+                    int label = labels[pos];
+                    if (label == -1)
+                        continue;
+
+                    if (!acc || label != accLabel) // Consecutive pixels usually share a label
+                    {
+                        acc = &local[label];
+                        accLabel = label;
+                        if (acc->area == 0)
+                            acc->init(x, y, channels);
+                    }
+                    acc->add(x, y, image.pixel(x, y));
+                }
+            } }, (int)partials.size());
+
+        std::unordered_map<int, Accumulator> merged;
+        for (const auto &partial : partials)
+        {
+            for (const auto &entry : partial)
+            {
+                Accumulator &acc = merged[entry.first];
+                if (acc.area == 0)
+                    acc = entry.second;
+                else
+                    acc.merge(entry.second);
+            }
+        }
+
+        std::vector<SegmentStat> table;
+        table.reserve(merged.size());
+        for (const auto &entry : merged)
+        {
+            const Accumulator &acc = entry.second;
+            double area = (double)acc.area;
+            SegmentStat stat{entry.first, (int)acc.area, acc.minX, acc.minY, acc.maxX, acc.maxY,
+                             acc.sumX / area, acc.sumY / area, std::vector<double>(channels)};
+            for (int c = 0; c < channels; ++c)
+                stat.meanColor[c] = acc.sumColor[c] / area;
+            table.push_back(stat);
+        }
+        std::sort(table.begin(), table.end(), [](const SegmentStat &a, const SegmentStat &b)
+                  { return a.label < b.label; });
+        return table;
+    }
+
+    // _________________________________________________________________________________________________________________
+    /// @brief Writes the table as CSV with a header row (one mean_cN column per channel)
+    static bool writeCSV(const std::vector<SegmentStat> &table, const char *filename)
+    {
+        FILE *file = fopen(filename, "w");
+        if (!file)
+        {
+            printf("Failed to open statistics file: %s\n", filename);
+            return false;
+        }
+
+        size_t channels = table.empty() ? 0 : table[0].meanColor.size();
+        fprintf(file, "label,area,min_x,min_y,max_x,max_y,centroid_x,centroid_y");
+        for (size_t c = 0; c < channels; ++c)
+            fprintf(file, ",mean_c%zu", c);
+        fprintf(file, "\n");
+
+        for (const SegmentStat &s : table)
+        {
+            fprintf(file, "%d,%d,%d,%d,%d,%d,%g,%g", s.label, s.area, s.minX, s.minY, s.maxX, s.maxY, s.centroidX, s.centroidY);
+            for (double mean : s.meanColor)
+                fprintf(file, ",%g", mean);
+            fprintf(file, "\n");
+        }
+
+        bool ok = !ferror(file);
+        fclose(file);
+        return ok;
+    }
+
+    // _________________________________________________________________________________________________________________
+    /// @brief Writes the table as little-endian binary records
+    /// @details "SSTA" | uint32 version (1) | uint32 count | uint32 channels | count x (int32 label, area,
+    ///          minX, minY, maxX, maxY, float64 centroidX, centroidY, channels x float64 mean)
+    static bool writeBinary(const std::vector<SegmentStat> &table, const char *filename)
+    {
+        uint32_t channels = table.empty() ? 0 : (uint32_t)table[0].meanColor.size();
+        std::vector<uint8_t> buffer = {'S', 'S', 'T', 'A'};
+        putLittleEndian(buffer, 1, 4);
+        putLittleEndian(buffer, table.size(), 4);
+        putLittleEndian(buffer, channels, 4);
+        for (const SegmentStat &s : table)
+        {
+            for (int value : {s.label, s.area, s.minX, s.minY, s.maxX, s.maxY})
+                putLittleEndian(buffer, (uint32_t)value, 4);
+            putDouble(buffer, s.centroidX);
+            putDouble(buffer, s.centroidY);
+            for (double mean : s.meanColor)
+                putDouble(buffer, mean);
+        }
+
+        FILE *file = fopen(filename, "wb");
+        if (!file)
+        {
+            printf("Failed to open statistics file: %s\n", filename);
+            return false;
+        }
+        fwrite(buffer.data(), 1, buffer.size(), file);
+        bool ok = !ferror(file);
+        fclose(file);
+        return ok;
+    }
+
+private:
+    struct Accumulator
+    {
+        long long area = 0;
+        int minX = 0, minY = 0, maxX = 0, maxY = 0;
+        long long sumX = 0, sumY = 0;
+        std::vector<long long> sumColor;
+
+        void init(int x, int y, int channels)
+        {
+            minX = maxX = x;
+            minY = maxY = y;
+            sumColor.assign(channels, 0);
+        }
+
+        void add(int x, int y, const uint8_t *pixel)
+        {
+            area++;
+            minX = std::min(minX, x);
+            minY = std::min(minY, y);
+            maxX = std::max(maxX, x);
+            maxY = std::max(maxY, y);
+            sumX += x;
+            sumY += y;
+            for (size_t c = 0; c < sumColor.size(); ++c)
+                sumColor[c] += pixel[c];
+        }
+
+        void merge(const Accumulator &other)
+        {
+            area += other.area;
+            minX = std::min(minX, other.minX);
+            minY = std::min(minY, other.minY);
+            maxX = std::max(maxX, other.maxX);
+            maxY = std::max(maxY, other.maxY);
+            sumX += other.sumX;
+            sumY += other.sumY;
+            for (size_t c = 0; c < sumColor.size(); ++c)
+                sumColor[c] += other.sumColor[c];
+        }
+    };
+
+    static void putLittleEndian(std::vector<uint8_t> &out, uint64_t value, int bytes)
+    {
+        for (int i = 0; i < bytes; ++i)
+            out.push_back((uint8_t)((value >> (8 * i)) & 0xFF));
+    }
+
+    static void putDouble(std::vector<uint8_t> &out, double value)
+    {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        putLittleEndian(out, bits, 8);
+    }
+};
+
+#endif
@@ -0,0 +1,151 @@
+#ifndef WEIGHT_PLANES_CPP
+#define WEIGHT_PLANES_CPP
+
+#include "neighborhood.cpp"
+#include "parallel.cpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/// @brief How CM obtains edge weights
+enum class EdgeWeights
+{
+    OnTheFly, // Evaluate the cost at every relaxation, no extra memory
+    Float,    // Precompute float planes: 4 bytes per pixel and plane, exact
+    Uint8     // Precompute uint8 planes: 1 byte per pixel and plane; float costs are rounded and saturate at 255
+};
+
+/// @brief A weight as uint8 planes store it: rounded, saturated at 255
+inline uint8_t roundWeight(float weight) { return (uint8_t)std::min(255L, std::lround(weight)); }
+
+// _____________________________________________________________________________________________________________________
+/// @brief Edge weights of a width x height image precomputed per direction, for a symmetric cost
+/// @details Only the forward half of the neighborhood gets a plane (right and down, plus down-right and down-left with
+///          diagonals); a backward arc reads the forward plane at its neighbor. Entry p of a plane holds the weight
+///          from p to p + offset; entries whose neighbor is outside the image are never read.
+///          With 8-connectivity this is 4 planes, and every arc is evaluated once instead of twice.
+template <typename T, bool Diagonal>
+class WeightPlanes
+{
+public:
+    static constexpr int planeCount = Diagonal ? 4 : 2;
+
+    // _________________________________________________________________________________________________________________
+    /// @brief Evaluates cost(p, q) for every forward arc, in parallel row bands
+    template <typename Cost>
+    WeightPlanes(const Cost &cost, int width, int height)
+        : weights((size_t)planeCount * width * height)
+    {
+        static const int forwardDx[4] = {1, 0, 1, -1};
+        static const int forwardDy[4] = {0, 1, 1, 1};
+        size_t pixelCount = (size_t)width * height;
+
+        // Each neighbor reads the plane of its own direction, or of the opposite one shifted to the neighbor
+        const Neighborhood<Diagonal> neighborhood(width);
+        for (int k = 0; k < Neighborhood<Diagonal>::count; k++)
+        {
+            bool forward = neighborhood.dy[k] > 0 || (neighborhood.dy[k] == 0 && neighborhood.dx[k] > 0);
+            int dx = forward ? neighborhood.dx[k] : -neighborhood.dx[k];
+            int dy = forward ? neighborhood.dy[k] : -neighborhood.dy[k];
+            int plane = 0;
+            while (forwardDx[plane] != dx || forwardDy[plane] != dy)
+                plane++;
+            base[k] = weights.data() + plane * pixelCount;
+            shift[k] = forward ? 0 : neighborhood.pixelOffset[k];
+        }
+
+        parallel::forRanges(0, height, [&](int fromRow, int toRow, int)
+                            {
+            for (int plane = 0; plane < planeCount; plane++)
+            {
+                int dx = forwardDx[plane], dy = forwardDy[plane];
+                int offset = dy * width + dx;
+                int fromX = dx < 0 ? 1 : 0;
+                int toX = dx > 0 ? width - 1 : width;
+                T *out = weights.data() + plane * pixelCount;
+                for (int y = fromRow; y < toRow && y + dy < height; y++)
+                {
+                    int row = y * width;
+                    fillRow(cost, row + fromX, row + toX, offset, out);
+                }
+            } });
+    }
+
+    /// @brief Weight of the arc from pixel 'from' to its neighbor with index k (Neighborhood order)
+    float weight(int from, int k) const { return (float)base[k][from + shift[k]]; }
+
+    /// @brief Bytes taken by the planes
+    size_t bytes() const { return weights.size() * sizeof(T); }
+
+private:
+    std::vector<T> weights;                    // planeCount planes of width * height entries
+    const T *base[Neighborhood<Diagonal>::count]; // Plane read by each neighbor index
+    int shift[Neighborhood<Diagonal>::count];     // Index shift into that plane (0 for forward arcs)
+
+    static T store(float weight)
+    {
+        if (std::is_same<T, uint8_t>::value)
+            return (T)roundWeight(weight);
+        return (T)weight;
+    }
+
+    /// @brief out[p] = cost(p, p + offset) for p in [from, to)
+    template <typename Cost>
+    static void fillRow(const Cost &cost, int from, int to, int offset, T *out)
+    {
+        for (int p = from; p < to; p++)
+            out[p] = store(cost(p, p + offset));
+    }
+
+    /// @brief Single-channel Euclidean cost into uint8: |a - b|, 16 pixels at a time with SSE2
+    static void fillRow(const EuclideanCostPolicy<1> &cost, int from, int to, int offset, T *out)
+    {
+        int p = from;
+        if (std::is_same<T, uint8_t>::value)
+        {
+#ifdef __SSE2__
+            for (; p + 16 <= to; p += 16)
+            {
+                __m128i a = _mm_loadu_si128((const __m128i *)(cost.data + p));
+                __m128i b = _mm_loadu_si128((const __m128i *)(cost.data + p + offset));
+                __m128i diff = _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+                _mm_storeu_si128((__m128i *)(out + p), diff);
+            }
+#endif
+        }
+        for (; p < to; p++)
+            out[p] = store(cost(p, p + offset));
+    }
+};
+
+// _____________________________________________________________________________________________________________________
+/// @brief Cost policy reading precomputed WeightPlanes: one load per relaxation
+template <typename T, bool Diagonal>
+struct PlaneCostPolicy
+{
+    const WeightPlanes<T, Diagonal> *planes;
+
+    bool symmetric() const { return true; }
+
+    float operator()(int from, int, int k) const { return planes->weight(from, k); }
+};
+
+// _____________________________________________________________________________________________________________________
+/// @brief Cost policy giving the weights of WeightPlanes<uint8_t> without building the planes, for small repairs
+template <typename Cost>
+struct RoundedCostPolicy
+{
+    Cost cost;
+
+    bool symmetric() const { return cost.symmetric(); }
+
+    float operator()(int from, int to, int k = 0) const { return roundWeight(cost(from, to, k)); }
+};
+
+#endif
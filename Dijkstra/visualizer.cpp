@@ -4,7 +4,10 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include "src/image/image.cpp"
+#include <chrono>
 #include <iostream>
+#include <memory>
+#include <string>
 #include <vector>
 #include "src/tinyfiledialogs.h"
 #include "src/dijkstra.cpp"
@@ -122,7 +125,7 @@ GLuint loadTexture(const char *filename)
                  GL_UNSIGNED_BYTE, mainImage->data);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    stbi_image_free(mainImage->data);
+    mainImage->release(); // The pixels live on the GPU now; keep only the dimensions
     return texture;
 }
 
@@ -356,11 +359,30 @@ void mainLoop(GLFWwindow *window, GLuint program, GLuint pointShader, GLuint tex
         int enterState = glfwGetKey(window, GLFW_KEY_ENTER);
         if (enterState == GLFW_PRESS && !justPressedEnter)
         {
-            stbi_set_flip_vertically_on_load(0);
-            Image img(filename);
-            img.write("output\\input.png");
-            Image imageGradient = gradient::generateGradient(img);
-            imageGradient.write("output\\gradient.png");
+            // The gradient, edge cost and forest are kept between presses, so a seed edit only repairs the forest
+            static std::string segmentedFile;
+            static Image imageGradient;
+            static std::unique_ptr<EuclidianDistance_EdgeCost> edgeCost;
+            static std::unique_ptr<CM> cm;
+            static std::map<int, std::tuple<uint8_t, uint8_t, uint8_t>> labelColors;
+            static std::set<std::tuple<uint8_t, uint8_t, uint8_t>> usedColors;
+
+            if (!cm || segmentedFile != filename)
+            {
+                cm.reset(); // Both view the previous gradient
+                edgeCost.reset();
+
+                stbi_set_flip_vertically_on_load(0);
+                Image img(filename);
+                img.write("output\\input.png");
+                imageGradient = gradient::generateGradient(img);
+                imageGradient.write("output\\gradient.png");
+
+                edgeCost.reset(new EuclidianDistance_EdgeCost(imageGradient)); // Create an edge cost object
+                cm.reset(new CM(imageGradient, std::map<int, int>(), true));   // Create a CM object with diagonal connections
+                cm->edgeCost = edgeCost.get();                                  // Set the edge cost function
+                segmentedFile = filename;
+            }
 
             std::map<int, int> seeds;
 
@@ -371,12 +393,12 @@ void mainLoop(GLFWwindow *window, GLuint program, GLuint pointShader, GLuint tex
                 seeds[y * imageGradient.w + x] = static_cast<int>(label);
             }
 
-            // Generate random colors for each seed label, ensuring they are different
-            std::map<int, std::tuple<uint8_t, uint8_t, uint8_t>> labelColors;
-            std::set<std::tuple<uint8_t, uint8_t, uint8_t>> usedColors;
+            // Generate random colors for new seed labels, ensuring they are different
             for (const auto &seed : seeds)
             {
                 int label = seed.second;
+                if (labelColors.count(label) > 0)
+                    continue; // Keep the color of a label across runs
                 std::tuple<uint8_t, uint8_t, uint8_t> color;
                 do
                 {
@@ -389,15 +411,13 @@ void mainLoop(GLFWwindow *window, GLuint program, GLuint pointShader, GLuint tex
                 usedColors.insert(color);
             }
 
-            EuclidianDistance_EdgeCost edgeCost(imageGradient); // Create an edge cost object
-
-            CM cm(imageGradient, seeds, true); // Create a CM object with diagonal connections
-            cm.edgeCost = &edgeCost;           // Set the edge cost function
-
             // _________________________________________________________________________________________________
-            // Run the connected components algorithm
+            // Run the connected components algorithm: a full run the first time, then only the seed changes
 
-            cm.run(); // Run the connected components algorithm
+            auto start = std::chrono::steady_clock::now();
+            int recomputed = cm->updateSeeds(seeds);
+            double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            printf("Segmentation updated in %.1f ms (%d pixels recomputed)\n", elapsed, recomputed);
 
             // _________________________________________________________________________________________________
             // Output
@@ -406,7 +426,7 @@ void mainLoop(GLFWwindow *window, GLuint program, GLuint pointShader, GLuint tex
             int lastLabel = -1;                                     // Initialize last label to -1
             for (int i = 0; i < imageGradient.w * imageGradient.h; ++i)
             {
-                int label = cm.labels[i];
+                int label = cm->labels[i];
 
                 if (label != -1) // If the pixel has a label
                 {